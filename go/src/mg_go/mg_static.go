@@ -0,0 +1,48 @@
+//go:build mg_static && !windows
+// +build mg_static,!windows
+
+/*
+   ----------------------------------------------------------------------------
+   | Package:     mg_go                                                       |
+   | OS:          Unix                                                        |
+   | Description: Static linking of the mg_dba library (libmg_dba.a)          |
+   | Author:      Chris Munt cmunt@mgateway.com                               |
+   |                         chris.e.munt@gmail.com                           |
+   | Copyright (c) 2017-2021 M/Gateway Developments Ltd,                      |
+   | Surrey UK.                                                               |
+   | All rights reserved.                                                     |
+   |                                                                          |
+   | http://www.mgateway.com                                                  |
+   |                                                                          |
+   | Licensed under the Apache License, Version 2.0 (the "License"); you may  |
+   | not use this file except in compliance with the License.                 |
+   | You may obtain a copy of the License at                                  |
+   |                                                                          |
+   | http://www.apache.org/licenses/LICENSE-2.0                               |
+   |                                                                          |
+   | Unless required by applicable law or agreed to in writing, software      |
+   | distributed under the License is distributed on an "AS IS" BASIS,        |
+   | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+   | See the License for the specific language governing permissions and      |
+   | limitations under the License.                                           |      
+   |                                                                          |
+   ----------------------------------------------------------------------------
+*/
+
+// Build the Go program with '-tags mg_static' to link libmg_dba.a (make static) into it instead of loading
+// mg_dba.so at run time.  Copy libmg_dba.a to this directory, or set CGO_LDFLAGS=-L<directory holding libmg_dba.a>
+
+package mg_go
+
+// #cgo LDFLAGS: -L${SRCDIR} -lmg_dba -ldl -lpthread
+// void * dbx_get_api(int version);
+import "C"
+import (
+   "unsafe"
+)
+
+func init() {
+   mg_dba_static = func() unsafe.Pointer {
+      return C.dbx_get_api(C.int(DBX_API_VERSION))
+   }
+}
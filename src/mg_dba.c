@@ -91,6 +91,82 @@ Version 1.3.16 15 June 2022:
 Version 1.3.17 12 January 2023:
    Remove the need to prefix global names with the '^' character for API-based connections to YottaDB.
 
+Version 1.3.18 10 July 2023:
+   Introduce $query based node traversal: dbx_nextnode(), dbx_previousnode() and their '_data' variants.
+   - Full subscript lists (and optionally data) are returned for a batch of nodes in a single call.
+
+Version 1.3.19 24 July 2023:
+   Introduce an optional, per-process, cache for global reads: dbx_cache_global(), dbx_cache_limits() and dbx_cache_clear().
+   - Caching is enabled global by global, with a time-to-live for cached nodes.
+   - Set, Delete, Increment and Merge operations in this process invalidate the affected nodes.
+
+Version 1.3.20 7 August 2023:
+   Introduce an optional, per-connection, write-behind buffer for Set operations: dbx_buffer() and dbx_flush().
+   - Repeated Sets to the same node are coalesced so that only the latest value is written.
+   - The buffer is flushed when its size, entry count or age limits are reached, on dbx_flush(), and before any other operation on the connection.
+   - Over network connections, the buffered requests are pipelined to the server in a single write.
+
+Version 1.3.21 4 September 2023:
+   Use scatter/gather (vectored) writes for network requests: netx_tcp_writev() and mg_db_sendv().
+   - Requests using the old MGWSI protocol are sent as header plus arguments, in place, without first being copied into a single buffer.
+   - Wait for the socket to become writable, rather than spinning, when a send would block.
+
+Version 1.3.22 18 September 2023:
+   Keep a persistent pair of send/receive buffers for each connection using the old MGWSI protocol.
+   - Replies are received directly into the caller's output buffer where they fit.
+   - Buffers grow geometrically and keep their contents when resized.
+   Use lookup tables and integer arithmetic to encode and decode the base-62 and decimal chunk sizes.
+   - Item headers are encoded directly into the request buffer.
+   - dbx_benchmark() with an input of 'codec <n>' times <n> encode/decode cycles of the codecs.
+   Allow the host to be specified as unix:/path to connect to a co-located server over a Unix domain socket.
+   Introduce standby connections for network based connectivity: dbx_standby().
+   - A background thread keeps up to <n> connected and initialized standby sockets for the connection.
+   - A standby socket is swapped in when the server closes the connection or fails to respond.
+   - Standby sockets follow dbx_setnamespace(): a socket swapped in is set to the namespace last set before anything is sent over it.
+   Introduce dbx_lock_many() and dbx_unlock_many() to lock and unlock a list of global nodes in one call.
+   - InterSystems API: one LOCK +(...) command.  YottaDB API: one ydb_lock_s() call when the connection holds no other locks.
+   - Otherwise, and over the network (one request per node), the nodes are locked one at a time.
+   - Record lock wait and hold times for each connection: dbx_lock_stats().
+   Cache YottaDB call-in descriptors for each connection and invoke functions through ydb_cip().
+   - Functions with up to 63 arguments can now be called under YottaDB (previously 3).
+   Cache the parsed function references (label^routine) and InterSystems routine flags for each connection.
+   - The cache is invalidated when the namespace is changed.
+   Introduce dbx_getproperties() and dbx_setproperties() to get and set a list of object properties in one call.
+   - These are only available for API based connectivity: the DB Server has no commands for them.
+   Keep a reference count for each OREF returned through a connection and introduce dbx_closeinstances() to release a list of OREFs in one call.
+   - An OREF that cannot be closed is kept, so that it can be released again.
+   - Over the network (where the DB Server has no command for a list) each OREF is closed with a request of its own.
+   - An object is closed on the server when the last reference to it is released.
+   Introduce an option to use the YottaDB SimpleThreadAPI (the ydb_*_st() functions) for API based connectivity.
+   - Select with the 'threaded' argument to dbx_open(): the first connection selects the API for the process and a connection asking for the other is refused.
+   - Each thread keeps its own transaction token and error buffer so that several connections can use YottaDB concurrently.
+   - A connection's requests must still be made one at a time: its request block is shared.
+   Return the connection handle from dbx_open() so that callers can address more than one connection.
+   Run the InterSystems callin session for each 'threaded' connection in a thread of its own.
+   - Requests for the connection, from whichever thread, are passed to its session thread.
+   - Requests still waiting for the session when the connection is closed fail with 'No Database Connection'.
+   - Several connections, each with its own session, can therefore be used concurrently in API mode.
+   - The session thread is a pthread on UNIX and is created with CreateThread() on Windows, where requests are passed to it with events.
+   Keep a process-wide, reference counted, registry of the database libraries loaded for API based connectivity.
+   - Connections to the same installation share the loaded library and its table of functions.
+   - An InterSystems library is unloaded when the last connection using it is closed.
+   Keep track of the current InterSystems namespace for each connection (API based connectivity).
+   - dbx_getnamespace() returns the namespace held for the connection without evaluating $Namespace.
+   - dbx_setnamespace() does nothing if the connection is already in the namespace requested.
+   - The namespace held is discarded after dbx_function(), dbx_classmethod() and dbx_method(), whose code can change it.
+   - Network based connections record the namespace opened, set ("sns") or reported ("gns") by the server.
+   - Cached global nodes are keyed by the namespace held: the cache is bypassed while the namespace is not known and the nodes a connection cached in a namespace are discarded when it leaves it.
+   Allocate the transient memory used by a request from a bump arena held by the connection.
+   - The arena is reset at the start and end of each request; allocations that do not fit are taken from the heap and freed on reset.
+   Introduce a static library build (make static) optimized with -O2 and LTO, with optional profile guided optimization.
+   Introduce dbx_get_api() to return a table of all the entry points to the library, so that bindings can resolve them with one lookup.
+   Let dbx_flush() write the buffered Sets only once the oldest has reached its maximum age (argument "1"), returning the time until it does.
+   - Bindings can call it from a timer so that an idle connection writes its buffer in time.
+   - dbx_setnamespace() now writes the buffered Sets before the namespace is changed over network based connections too.
+   Introduce dbx_deadline() to set a deadline for the requests made through a connection.
+   - The deadline is honored when waiting for the connection's mutex, for network reads and writes, for locks and before a request is passed to a YottaDB transaction thread.
+   - A request whose deadline passes returns the error 'Request deadline exceeded'; a network connection abandoned part way through a request is not used again.
+
 */
 
 
@@ -103,6 +179,35 @@ extern int errno;
 
 static NETXSOCK      netx_so        = {0, 0, 0, 0, 0, 0, 0, {'\0'}};
 static DBXCON *      connection[DBX_MAXCONS];
+static DBXCACHE      dbx_cache; /* v1.3.19 */
+static DBXSTBY *     dbx_stby_list  = NULL; /* v1.3.22 */
+static int           dbx_stby_running = 0;
+static DBXYDBST      dbx_ydb_st;
+static DBXLIBREG *   dbx_lib_list   = NULL;
+static DBXAPI        dbx_api;
+static DBX_TLS unsigned long long dbx_ydb_tptoken = YDB_NOTTP;
+static DBX_TLS char  dbx_ydb_errbuf[DBX_ERROR_SIZE];
+
+/* v1.3.22: lookup tables for the base-62 chunk size codec */
+static const unsigned char mg_size64_enc[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+static const unsigned char mg_size64_dec[256] = {
+                         0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+                         0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+                         0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+                         0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  0,  0,  0,  0,  0,  0,
+                         0, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24,
+                        25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35,  0,  0,  0,  0,  0,
+                         0, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50,
+                        51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61,  0,  0,  0,  0,  0,
+                         0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+                         0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+                         0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+                         0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+                         0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+                         0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+                         0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+                         0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0
+                     };
 
 MG_MALLOC            dbx_ext_malloc = NULL;
 MG_REALLOC           dbx_ext_realloc = NULL;
@@ -148,6 +253,71 @@ DBX_EXTFUN(int) dbx_init()
 }
 
 
+/* v1.3.22: 'version' is the version of the table the caller was built for (DBX_API_VERSION) */
+DBX_EXTFUN(DBXAPI *) dbx_get_api(int version)
+{
+   if (version < 1) {
+      return NULL;
+   }
+
+   mg_enter_critical_section((void *) &dbx_global_mutex);
+   if (!dbx_api.size) {
+      dbx_api.p_init               = dbx_init;
+      dbx_api.p_version            = dbx_version;
+      dbx_api.p_open               = dbx_open;
+      dbx_api.p_close              = dbx_close;
+      dbx_api.p_set                = dbx_set;
+      dbx_api.p_get                = dbx_get;
+      dbx_api.p_next               = dbx_next;
+      dbx_api.p_next_data          = dbx_next_data;
+      dbx_api.p_previous           = dbx_previous;
+      dbx_api.p_previous_data      = dbx_previous_data;
+      dbx_api.p_nextnode           = dbx_nextnode;
+      dbx_api.p_nextnode_data      = dbx_nextnode_data;
+      dbx_api.p_previousnode       = dbx_previousnode;
+      dbx_api.p_previousnode_data  = dbx_previousnode_data;
+      dbx_api.p_delete             = dbx_delete;
+      dbx_api.p_defined            = dbx_defined;
+      dbx_api.p_increment          = dbx_increment;
+      dbx_api.p_merge              = dbx_merge;
+      dbx_api.p_lock               = dbx_lock;
+      dbx_api.p_unlock             = dbx_unlock;
+      dbx_api.p_lock_many          = dbx_lock_many;
+      dbx_api.p_unlock_many        = dbx_unlock_many;
+      dbx_api.p_lock_stats         = dbx_lock_stats;
+      dbx_api.p_tstart             = dbx_tstart;
+      dbx_api.p_tlevel             = dbx_tlevel;
+      dbx_api.p_tcommit            = dbx_tcommit;
+      dbx_api.p_trollback          = dbx_trollback;
+      dbx_api.p_function           = dbx_function;
+      dbx_api.p_classmethod        = dbx_classmethod;
+      dbx_api.p_method             = dbx_method;
+      dbx_api.p_getproperty        = dbx_getproperty;
+      dbx_api.p_setproperty        = dbx_setproperty;
+      dbx_api.p_getproperties      = dbx_getproperties;
+      dbx_api.p_setproperties      = dbx_setproperties;
+      dbx_api.p_closeinstance      = dbx_closeinstance;
+      dbx_api.p_closeinstances     = dbx_closeinstances;
+      dbx_api.p_getnamespace       = dbx_getnamespace;
+      dbx_api.p_setnamespace       = dbx_setnamespace;
+      dbx_api.p_sleep              = dbx_sleep;
+      dbx_api.p_benchmark          = dbx_benchmark;
+      dbx_api.p_cache_global       = dbx_cache_global;
+      dbx_api.p_cache_limits       = dbx_cache_limits;
+      dbx_api.p_cache_clear        = dbx_cache_clear;
+      dbx_api.p_buffer             = dbx_buffer;
+      dbx_api.p_flush              = dbx_flush;
+      dbx_api.p_standby            = dbx_standby;
+      dbx_api.p_deadline           = dbx_deadline;
+      dbx_api.version = DBX_API_VERSION;
+      dbx_api.size = (int) sizeof(DBXAPI);
+   }
+   mg_leave_critical_section((void *) &dbx_global_mutex);
+
+   return &dbx_api;
+}
+
+
 DBX_EXTFUN(int) dbx_version(int index, char *output, int output_len)
 {
    DBXMETH *pmeth;
@@ -260,6 +430,7 @@ DBX_EXTFUN(int) dbx_open(unsigned char *input, unsigned char *output)
    pcon->ip_address[0] = '\0';
    pcon->port = 0;
    pcon->timeout = NETX_TIMEOUT;
+   pcon->threaded = 0;
 
    for (n = 0; n < pmeth->argc; n ++) {
 
@@ -352,6 +523,13 @@ DBX_EXTFUN(int) dbx_open(unsigned char *input, unsigned char *output)
                pcon->timeout = NETX_TIMEOUT;
             }
             break;
+         case 14: /* v1.3.22 */
+            len = (len < 32) ? len : 32;
+            strncpy(nstr, p, len);
+            nstr[len] = '\0';
+            mg_lcase(nstr);
+            pcon->threaded = (!strcmp(nstr, "1") || !strcmp(nstr, "true")) ? 1 : 0;
+            break;
 
          default:
             break;
@@ -385,7 +563,7 @@ DBX_EXTFUN(int) dbx_open(unsigned char *input, unsigned char *output)
       goto dbx_open_exit;
    }
 
-   if (!pcon->shdir[0] && pcon->ip_address[0] && pcon->port) {
+   if (!pcon->shdir[0] && pcon->ip_address[0] && (pcon->port || !strncmp(pcon->ip_address, NETX_UNIX_PREFIX, NETX_UNIX_PREFIX_LEN))) { /* v1.3.22 */
 
       if (strstr(pcon->server_software, "zmgwsi")) {
          pcon->p_srv = (void *) mg_malloc(sizeof(MGSRV), 0);
@@ -429,7 +607,7 @@ DBX_EXTFUN(int) dbx_open(unsigned char *input, unsigned char *output)
          }
 
          pcon->connected = 2; /* network connection for old protocol */
-         mg_create_string(pmeth, (void *) &rc, DBX_DTYPE_INT);
+         mg_create_string(pmeth, (void *) &chndle, DBX_DTYPE_INT); /* v1.3.22: return the connection handle */
 
          return rc;
       }
@@ -452,7 +630,8 @@ DBX_EXTFUN(int) dbx_open(unsigned char *input, unsigned char *output)
       }
 
       pcon->connected = 2; /* network connection */
-      mg_create_string(pmeth, (void *) &rc, DBX_DTYPE_INT);
+      mg_namespace_set(pcon, pcon->nspace[0] ? pcon->nspace : NULL); /* v1.3.22: the server's default namespace is not known */
+      mg_create_string(pmeth, (void *) &chndle, DBX_DTYPE_INT); /* v1.3.22: return the connection handle */
 
       return 0;
    }
@@ -480,7 +659,7 @@ dbx_open_exit:
 
    if (rc == CACHE_SUCCESS) {
       pcon->connected = 1;
-      mg_create_string(pmeth, (void *) &rc, DBX_DTYPE_INT);
+      mg_create_string(pmeth, (void *) &chndle, DBX_DTYPE_INT); /* v1.3.22: return the connection handle */
    }
    else {
       pcon->connected = 0;
@@ -496,6 +675,9 @@ DBX_EXTFUN(int) dbx_close(unsigned char *input, unsigned char *output)
    int rc;
    DBXMETH *pmeth;
    DBXCON *pcon;
+   DBXYDBSO *p_ydb_so;
+
+   DBX_SESSION_CALL(dbx_close, input, output);
 
    pmeth = mg_unpack_header(input, output);
    pcon = pmeth->pcon;
@@ -508,9 +690,25 @@ DBX_EXTFUN(int) dbx_close(unsigned char *input, unsigned char *output)
    if (pcon->chndle >= 0 && pcon->chndle < DBX_MAXCONS) {
       connection[pcon->chndle] = NULL;
    }
+   pcon->deadline = 0; /* v1.3.22 */
 
    mg_unpack_arguments(pmeth);
 
+   if (pcon->p_wbuf) { /* v1.3.20 */
+      DBX_LOCK(rc, 0);
+      mg_wbuf_flush(pcon);
+      mg_free((void *) pcon->p_wbuf, 0);
+      pcon->p_wbuf = NULL;
+      DBX_UNLOCK(rc);
+   }
+
+   if (pcon->p_stby) { /* v1.3.22: the background thread closes the standby sockets */
+      mg_enter_critical_section((void *) &dbx_global_mutex);
+      ((DBXSTBY *) pcon->p_stby)->closed = 1;
+      pcon->p_stby = NULL;
+      mg_leave_critical_section((void *) &dbx_global_mutex);
+   }
+
    if (pcon->connected == 2) {
       if (pcon->p_srv) {
          rc = 0;
@@ -524,8 +722,11 @@ DBX_EXTFUN(int) dbx_close(unsigned char *input, unsigned char *output)
    }
 
    if (pcon->dbtype == DBX_DBTYPE_YOTTADB) {
-      if (pcon->p_ydb_so->loaded) {
-         rc = pcon->p_ydb_so->p_ydb_exit();
+      ydb_ci_free(pcon); /* v1.3.22 */
+
+      p_ydb_so = pcon->p_ydb_so;
+      if (mg_library_release(pcon) <= 0 && p_ydb_so->loaded) { /* v1.3.22: the runtime is shared, so shut it down with the last connection */
+         rc = p_ydb_so->p_ydb_exit();
          /* printf("\r\np_ydb_exit=%d\r\n", rc); */
       }
 
@@ -536,9 +737,6 @@ DBX_EXTFUN(int) dbx_close(unsigned char *input, unsigned char *output)
       pcon->p_ydb_so->p_library = NULL;
       pcon->p_ydb_so->loaded = 0;
 */
-      strcpy(pcon->p_ydb_so->libdir, "");
-      strcpy(pcon->p_ydb_so->libnam, "");
-
    }
    else {
       if (pcon->p_isc_so->loaded) {
@@ -550,32 +748,48 @@ DBX_EXTFUN(int) dbx_close(unsigned char *input, unsigned char *output)
          DBX_UNLOCK(rc);
       }
 
+      if (pcon->p_sess) { /* v1.3.22: we are in the session thread, which ends once this call returns */
+         mg_enter_critical_section((void *) &dbx_global_mutex);
+         ((DBXSESS *) pcon->p_sess)->end = 1;
+         pcon->p_sess = NULL;
+         mg_leave_critical_section((void *) &dbx_global_mutex);
+      }
+
       strcpy(pcon->error, "");
       mg_create_string(pmeth, (void *) "1", DBX_DTYPE_STR);
 
-      mg_dso_unload(pcon->p_isc_so->p_library); 
-
-      pcon->p_isc_so->p_library = NULL;
-      pcon->p_isc_so->loaded = 0;
-
-      strcpy(pcon->p_isc_so->libdir, "");
-      strcpy(pcon->p_isc_so->libnam, "");
+      mg_library_release(pcon); /* v1.3.22: the library is unloaded with its last connection */
    }
 
 dbx_close_tcp:
 
+   mg_db_free_buffers(pcon); /* v1.3.22 */
+   mg_function_cache_clear(pcon, 1);
+   mg_oref_free(pcon);
+   mg_lock_free(pcon);
+   mg_arena_free(pcon);
+
    strcpy(pcon->p_zv->version, "");
 
    strcpy(pcon->shdir, "");
    strcpy(pcon->username, "");
    strcpy(pcon->password, "");
    strcpy(pcon->nspace, "");
+   strcpy(pcon->cur_nspace, "");
    strcpy(pcon->input_device, "");
    strcpy(pcon->output_device, "");
    strcpy(pcon->debug_str, "");
 
    rc = mg_mutex_destroy(pcon->p_db_mutex);
 
+#if defined(MG_PGO)
+   /* v1.3.22: Go programs end without running the C exit handlers, so write the profile data as each connection is closed */
+   if (__gcov_dump && __gcov_reset) {
+      __gcov_dump();
+      __gcov_reset();
+   }
+#endif
+
    rc = CACHE_SUCCESS;
    if (rc == CACHE_SUCCESS) {
       mg_create_string(pmeth, (void *) &rc, DBX_DTYPE_INT);
@@ -590,14 +804,17 @@ dbx_close_tcp:
 
 DBX_EXTFUN(int) dbx_set(unsigned char *input, unsigned char *output)
 {
+   DBX_SESSION_CALL(dbx_set, input, output);
    return dbx_set_x(mg_unpack_header(input, output));
 }
 
 
 DBX_EXTFUN(int) dbx_set_x(DBXMETH *pmeth)
 {
-   int rc;
+   int rc, cache_klen, cache_ttl;
+   unsigned char cache_key[DBX_MAXKEY];
    DBXCON *pcon;
+   DBXWBUF *pwbuf;
 
    pcon = pmeth->pcon;
 
@@ -606,8 +823,26 @@ DBX_EXTFUN(int) dbx_set_x(DBXMETH *pmeth)
       return 1;
    }
 
+   /* v1.3.19 */
+   cache_klen = mg_cache_key(pmeth, cache_key, DBX_MAXKEY, 1, &cache_ttl);
+
    DBX_LOCK(rc, 0);
 
+   if (pcon->p_wbuf) { /* v1.3.20 */
+      rc = mg_wbuf_add(pmeth);
+      if (rc == CACHE_SUCCESS) {
+         pwbuf = (DBXWBUF *) pcon->p_wbuf;
+         if (pwbuf->error[0]) { /* report the failure of an earlier buffered Set */
+            mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, pwbuf->error);
+            pwbuf->error[0] = '\0';
+         }
+         else {
+            mg_create_string(pmeth, (void *) &rc, DBX_DTYPE_INT);
+         }
+         goto dbx_set_exit;
+      }
+   }
+
    if (pcon->connected == 2) {
       strcpy(pmeth->command, "S");
       rc = netx_tcp_command(pmeth, 0);
@@ -643,6 +878,12 @@ DBX_EXTFUN(int) dbx_set_x(DBXMETH *pmeth)
 
 dbx_set_exit:
 
+   if (cache_klen) { /* v1.3.19 */
+      mg_enter_critical_section((void *) &dbx_global_mutex);
+      mg_cache_invalidate(cache_key, cache_klen, cache_ttl < 0 ? 1 : 0); /* v1.3.22: everything cached for the server if the namespace is not known */
+      mg_leave_critical_section((void *) &dbx_global_mutex);
+   }
+
    DBX_UNLOCK(rc);
 
    mg_cleanup(pmeth);
@@ -671,13 +912,17 @@ DBX_EXTFUN(int) dbx_set_ex(DBXMETH *pmeth)
 
 DBX_EXTFUN(int) dbx_get(unsigned char *input, unsigned char *output)
 {
+   DBX_SESSION_CALL(dbx_get, input, output);
    return dbx_get_x(mg_unpack_header(input, output));
 }
 
 
 DBX_EXTFUN(int) dbx_get_x(DBXMETH *pmeth)
 {
-   int rc;
+   int rc, cache_klen, cache_ttl, dsort, dtype;
+   unsigned long len;
+   unsigned long long cache_gen;
+   unsigned char cache_key[DBX_MAXKEY];
    DBXCON *pcon;
 
    pcon = pmeth->pcon;
@@ -688,6 +933,22 @@ DBX_EXTFUN(int) dbx_get_x(DBXMETH *pmeth)
    }
 
    DBX_LOCK(rc, 0);
+   DBX_WBUF_FLUSH(pcon); /* v1.3.20 */
+
+   /* v1.3.19: look in the cache once any buffered Sets have been written */
+   cache_klen = 0;
+   cache_gen = 0;
+   if (pcon->tlevel == 0) {
+      cache_klen = mg_cache_key(pmeth, cache_key, DBX_MAXKEY, 0, &cache_ttl);
+      if (cache_ttl < 0) { /* v1.3.22: the namespace is not known, so neither look in the cache nor add to it */
+         cache_klen = 0;
+      }
+      if (cache_klen && mg_cache_get(pmeth, cache_key, cache_klen, &cache_gen)) {
+         cache_klen = 0;
+         rc = CACHE_SUCCESS;
+         goto dbx_get_exit;
+      }
+   }
 
    if (pcon->connected == 2) {
       strcpy(pmeth->command, "G");
@@ -723,6 +984,13 @@ DBX_EXTFUN(int) dbx_get_x(DBXMETH *pmeth)
 
 dbx_get_exit:
 
+   if (cache_klen && rc == CACHE_SUCCESS) { /* v1.3.19 */
+      len = mg_get_block_size(&(pmeth->output_val.svalue), 0, &dsort, &dtype);
+      if (dsort == DBX_DSORT_DATA) {
+         mg_cache_put(cache_key, cache_klen, cache_ttl, (unsigned char *) pmeth->output_val.svalue.buf_addr + 5, (int) len, cache_gen);
+      }
+   }
+
    DBX_UNLOCK(rc);
 
    mg_cleanup(pmeth);
@@ -767,6 +1035,7 @@ DBX_EXTFUN(int) dbx_get_ex(DBXMETH *pmeth)
 
 DBX_EXTFUN(int) dbx_next(unsigned char *input, unsigned char *output)
 {
+   DBX_SESSION_CALL(dbx_next, input, output);
    return dbx_next_x(mg_unpack_header(input, output));
 }
 
@@ -784,6 +1053,7 @@ DBX_EXTFUN(int) dbx_next_x(DBXMETH *pmeth)
    }
 
    DBX_LOCK(rc, 0);
+   DBX_WBUF_FLUSH(pcon); /* v1.3.20 */
 
    if (pcon->connected == 2) {
       strcpy(pmeth->command, "O");
@@ -831,6 +1101,7 @@ dbx_next_exit:
 /* v1.3.13 */
 DBX_EXTFUN(int) dbx_next_data(unsigned char *input, unsigned char *output)
 {
+   DBX_SESSION_CALL(dbx_next_data, input, output);
    return dbx_next_data_x(mg_unpack_header(input, output));
 }
 
@@ -848,6 +1119,7 @@ DBX_EXTFUN(int) dbx_next_data_x(DBXMETH *pmeth)
    }
 
    DBX_LOCK(rc, 0);
+   DBX_WBUF_FLUSH(pcon); /* v1.3.20 */
 
    if (pcon->connected == 2) {
       strcpy(pmeth->command, "NO");
@@ -974,6 +1246,7 @@ DBX_EXTFUN(int) dbx_next_ex(DBXMETH *pmeth)
 
 DBX_EXTFUN(int) dbx_previous(unsigned char *input, unsigned char *output)
 {
+   DBX_SESSION_CALL(dbx_previous, input, output);
    return dbx_previous_x(mg_unpack_header(input, output));
 }
 
@@ -991,6 +1264,7 @@ DBX_EXTFUN(int) dbx_previous_x(DBXMETH *pmeth)
    }
 
    DBX_LOCK(rc, 0);
+   DBX_WBUF_FLUSH(pcon); /* v1.3.20 */
 
    if (pcon->connected == 2) {
       strcpy(pmeth->command, "P");
@@ -1037,6 +1311,7 @@ dbx_previous_exit:
 
 DBX_EXTFUN(int) dbx_previous_data(unsigned char *input, unsigned char *output)
 {
+   DBX_SESSION_CALL(dbx_previous_data, input, output);
    return dbx_previous_data_x(mg_unpack_header(input, output));
 }
 
@@ -1054,6 +1329,7 @@ DBX_EXTFUN(int) dbx_previous_data_x(DBXMETH *pmeth)
    }
 
    DBX_LOCK(rc, 0);
+   DBX_WBUF_FLUSH(pcon); /* v1.3.20 */
 
    if (pcon->connected == 2) {
       strcpy(pmeth->command, "NO");
@@ -1177,15 +1453,370 @@ DBX_EXTFUN(int) dbx_previous_ex(DBXMETH *pmeth)
 }
 
 
+/* v1.3.18 */
+DBX_EXTFUN(int) dbx_nextnode(unsigned char *input, unsigned char *output)
+{
+   DBX_SESSION_CALL(dbx_nextnode, input, output);
+   return dbx_nextnode_x(mg_unpack_header(input, output));
+}
+
+
+DBX_EXTFUN(int) dbx_nextnode_x(DBXMETH *pmeth)
+{
+   pmeth->getdata = 0;
+   pmeth->dir = 1;
+
+   return dbx_query_x(pmeth);
+}
+
+
+DBX_EXTFUN(int) dbx_nextnode_data(unsigned char *input, unsigned char *output)
+{
+   DBX_SESSION_CALL(dbx_nextnode_data, input, output);
+   return dbx_nextnode_data_x(mg_unpack_header(input, output));
+}
+
+
+DBX_EXTFUN(int) dbx_nextnode_data_x(DBXMETH *pmeth)
+{
+   pmeth->getdata = 1;
+   pmeth->dir = 1;
+
+   return dbx_query_x(pmeth);
+}
+
+
+DBX_EXTFUN(int) dbx_previousnode(unsigned char *input, unsigned char *output)
+{
+   DBX_SESSION_CALL(dbx_previousnode, input, output);
+   return dbx_previousnode_x(mg_unpack_header(input, output));
+}
+
+
+DBX_EXTFUN(int) dbx_previousnode_x(DBXMETH *pmeth)
+{
+   pmeth->getdata = 0;
+   pmeth->dir = -1;
+
+   return dbx_query_x(pmeth);
+}
+
+
+DBX_EXTFUN(int) dbx_previousnode_data(unsigned char *input, unsigned char *output)
+{
+   DBX_SESSION_CALL(dbx_previousnode_data, input, output);
+   return dbx_previousnode_data_x(mg_unpack_header(input, output));
+}
+
+
+DBX_EXTFUN(int) dbx_previousnode_data_x(DBXMETH *pmeth)
+{
+   pmeth->getdata = 1;
+   pmeth->dir = -1;
+
+   return dbx_query_x(pmeth);
+}
+
+
+/*
+   Input:  global, subscripts of the seed node (if any), maximum number of nodes to return.
+   Output: for each node found, one subscript block per key followed by a data block (empty if data not requested).
+           Fewer nodes than requested are returned if the output buffer fills up.
+*/
+
+DBX_EXTFUN(int) dbx_query_x(DBXMETH *pmeth)
+{
+   int rc;
+   DBXCON *pcon;
+
+   pcon = pmeth->pcon;
+
+   if (!pcon || !pcon->connected) {
+      mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, "No Database Connection");
+      return 1;
+   }
+
+   if (pcon->connected == 2) {
+      mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, "Node traversal is not available over network-based connectivity");
+      return 1;
+   }
+
+   DBX_LOCK(rc, 0);
+   DBX_WBUF_FLUSH(pcon); /* v1.3.20 */
+
+   pmeth->increment = 0;
+   pmeth->merge = 0;
+   pmeth->lock = 0;
+   pmeth->query = 1;
+   rc = mg_global_reference(pmeth);
+   pmeth->query = 0;
+   if (rc != CACHE_SUCCESS) {
+      mg_error_message(pmeth, rc);
+      goto dbx_query_exit;
+   }
+
+   if (pcon->dbtype == DBX_DBTYPE_YOTTADB) {
+      if (pcon->tlevel > 0) {
+         pmeth->p_dbxfun = (int (*) (struct tagDBXMETH * pmeth)) dbx_query_ex;
+         rc = ydb_transaction_task(pmeth, YDB_TPCTX_DB);
+      }
+      else {
+         rc = dbx_query_ex(pmeth);
+      }
+   }
+   else {
+      rc = dbx_query_ex(pmeth);
+   }
+
+   if (rc != CACHE_SUCCESS) {
+      pmeth->output_val.svalue.len_used = 5;
+      mg_error_message(pmeth, rc);
+   }
+
+dbx_query_exit:
+
+   DBX_UNLOCK(rc);
+
+   mg_cleanup(pmeth);
+
+   return 0;
+}
+
+
+DBX_EXTFUN(int) dbx_query_ex(DBXMETH *pmeth)
+{
+   int rc, n, len, nsubs, nkeys, max_nodes, nodes, seeds, full, node_offset;
+   int kpos[DBX_MAXARGS], klen[DBX_MAXARGS];
+   unsigned int max, dsize;
+   char buffer[32];
+   char *pkeys;
+   DBXSTR str;
+   CACHE_EXSTR zstr;
+   ydb_buffer_t *in_keys, *out_keys;
+   ydb_buffer_t keys[2][DBX_MAXARGS];
+   DBXCON *pcon = pmeth->pcon;
+
+   nsubs = 0;
+   max_nodes = 1;
+   if (pmeth->argc > 1) {
+      nsubs = pmeth->argc - 2;
+      len = (int) pmeth->args[pmeth->argc - 1].svalue.len_used;
+      if (len < 16) {
+         strncpy(buffer, pmeth->args[pmeth->argc - 1].svalue.buf_addr, len);
+         buffer[len] = '\0';
+         max_nodes = (int) strtol(buffer, NULL, 10);
+      }
+   }
+   if (max_nodes < 1) {
+      max_nodes = 1;
+   }
+
+   max = 0;
+   if (pmeth->output_val.svalue.len_alloc > 8) {
+      max = (pmeth->output_val.svalue.len_alloc - 7); /* 5 Byte header plus 2 spare */
+   }
+
+   pmeth->output_val.svalue.len_used = 5;
+   pmeth->output_val.offset = 5;
+
+   rc = CACHE_SUCCESS;
+   nodes = 0;
+   seeds = 0;
+   full = 0;
+
+   if (pcon->dbtype == DBX_DBTYPE_YOTTADB) {
+      pkeys = (char *) mg_arena_alloc(pcon, sizeof(char) * (2 * DBX_MAXARGS * DBX_MAXKEY)); /* v1.3.22 */
+      if (!pkeys) {
+         return CACHE_FAILURE;
+      }
+      for (n = 0; n < DBX_MAXARGS; n ++) {
+         keys[0][n].buf_addr = pkeys + (n * DBX_MAXKEY);
+         keys[0][n].len_alloc = DBX_MAXKEY;
+         keys[0][n].len_used = 0;
+         keys[1][n].buf_addr = pkeys + ((DBX_MAXARGS + n) * DBX_MAXKEY);
+         keys[1][n].len_alloc = DBX_MAXKEY;
+         keys[1][n].len_used = 0;
+      }
+
+      in_keys = &pmeth->yargs[0];
+      nkeys = nsubs;
+
+      while (nodes < max_nodes) {
+         out_keys = keys[seeds % 2];
+         seeds ++;
+         n = DBX_MAXARGS;
+         if (pmeth->dir == 1) {
+            rc = pcon->p_ydb_so->p_ydb_node_next_s(&(pmeth->args[0].svalue), nkeys, in_keys, &n, out_keys);
+         }
+         else {
+            rc = pcon->p_ydb_so->p_ydb_node_previous_s(&(pmeth->args[0].svalue), nkeys, in_keys, &n, out_keys);
+         }
+         if (rc == YDB_ERR_NODEEND || n == YDB_NODE_END) {
+            rc = YDB_OK;
+            break;
+         }
+         if (rc != YDB_OK) {
+            break;
+         }
+         nkeys = n;
+
+         node_offset = pmeth->output_val.svalue.len_used;
+         for (n = 0; n < nkeys; n ++) {
+            if ((pmeth->output_val.svalue.len_used + out_keys[n].len_used + 5) > max) {
+               full = 1;
+               break;
+            }
+            mg_add_block_size(&(pmeth->output_val.svalue), pmeth->output_val.svalue.len_used, (unsigned long) out_keys[n].len_used, DBX_DSORT_SUBSCRIPT, DBX_DTYPE_DBXSTR);
+            pmeth->output_val.svalue.len_used += 5;
+            memcpy((void *) (pmeth->output_val.svalue.buf_addr + pmeth->output_val.svalue.len_used), (void *) out_keys[n].buf_addr, (size_t) out_keys[n].len_used);
+            pmeth->output_val.svalue.len_used += out_keys[n].len_used;
+         }
+         if (full || (pmeth->output_val.svalue.len_used + 5) > max) {
+            full = 1;
+            pmeth->output_val.svalue.len_used = node_offset;
+            break;
+         }
+
+         dsize = 0;
+         if (pmeth->getdata) {
+            str.buf_addr = (pmeth->output_val.svalue.buf_addr + (pmeth->output_val.svalue.len_used + 5));
+            str.len_alloc = max - (pmeth->output_val.svalue.len_used + 5);
+            str.len_used = 0;
+            rc = pcon->p_ydb_so->p_ydb_get_s(&(pmeth->args[0].svalue), nkeys, out_keys, &str);
+            if (rc == YDB_ERR_GVUNDEF) { /* node removed since the $query: skip it */
+               rc = YDB_OK;
+               pmeth->output_val.svalue.len_used = node_offset;
+               in_keys = out_keys;
+               continue;
+            }
+            if (rc != YDB_OK) {
+               if (str.len_used > str.len_alloc) {
+                  rc = YDB_OK;
+                  full = 1;
+               }
+               pmeth->output_val.svalue.len_used = node_offset;
+               break;
+            }
+            dsize = str.len_used;
+         }
+         mg_add_block_size(&(pmeth->output_val.svalue), pmeth->output_val.svalue.len_used, (unsigned long) dsize, DBX_DSORT_DATA, DBX_DTYPE_DBXSTR);
+         pmeth->output_val.svalue.len_used += (dsize + 5);
+
+         in_keys = out_keys;
+         nodes ++;
+      }
+   }
+   else {
+      nkeys = nsubs;
+
+      while (nodes < max_nodes) {
+         if (seeds > 0) {
+            /* the last node found is the seed for the next $query */
+            rc = isc_push_node(pcon, &(pmeth->args[0].svalue), pmeth->output_val.svalue.buf_addr, nkeys, kpos, klen);
+            if (rc != CACHE_SUCCESS) {
+               break;
+            }
+         }
+         rc = pcon->p_isc_so->p_CacheGlobalQuery(nkeys, pmeth->dir, 0);
+         if (rc != CACHE_SUCCESS) {
+            break;
+         }
+         zstr.len = 0;
+         zstr.str.ch = NULL;
+         rc = pcon->p_isc_so->p_CachePopExStr(&zstr);
+         if (rc != CACHE_SUCCESS) {
+            break;
+         }
+         if (zstr.len == 0) {
+            pcon->p_isc_so->p_CacheExStrKill(&zstr);
+            break;
+         }
+
+         node_offset = pmeth->output_val.svalue.len_used;
+         len = 0;
+         for (n = 0; len < (int) zstr.len; n ++) {
+            if (n >= DBX_MAXARGS || (pmeth->output_val.svalue.len_used + 5) > max) {
+               full = 1;
+               break;
+            }
+            kpos[n] = pmeth->output_val.svalue.len_used + 5;
+            klen[n] = isc_list_item((unsigned char *) zstr.str.ch, (int) zstr.len, &len, pmeth->output_val.svalue.buf_addr + kpos[n], (int) (max - kpos[n]));
+            if (klen[n] < 0) {
+               full = 1;
+               break;
+            }
+            mg_add_block_size(&(pmeth->output_val.svalue), pmeth->output_val.svalue.len_used, (unsigned long) klen[n], DBX_DSORT_SUBSCRIPT, DBX_DTYPE_DBXSTR);
+            pmeth->output_val.svalue.len_used += (klen[n] + 5);
+         }
+         pcon->p_isc_so->p_CacheExStrKill(&zstr);
+         if (full || (pmeth->output_val.svalue.len_used + 5) > max) {
+            full = 1;
+            pmeth->output_val.svalue.len_used = node_offset;
+            break;
+         }
+         nkeys = n;
+         seeds ++;
+
+         dsize = 0;
+         if (pmeth->getdata) {
+            rc = isc_push_node(pcon, &(pmeth->args[0].svalue), pmeth->output_val.svalue.buf_addr, nkeys, kpos, klen);
+            if (rc == CACHE_SUCCESS) {
+               rc = pcon->p_isc_so->p_CacheGlobalGet(nkeys, 0);
+            }
+            if (rc == CACHE_ERUNDEF) { /* node removed since the $query: skip it */
+               rc = CACHE_SUCCESS;
+               pmeth->output_val.svalue.len_used = node_offset;
+               continue;
+            }
+            if (rc == CACHE_SUCCESS) {
+               zstr.len = 0;
+               zstr.str.ch = NULL;
+               rc = pcon->p_isc_so->p_CachePopExStr(&zstr);
+               if (rc == CACHE_SUCCESS) {
+                  if ((pmeth->output_val.svalue.len_used + zstr.len + 5) > max) {
+                     full = 1;
+                  }
+                  else {
+                     dsize = zstr.len;
+                     memcpy((void *) (pmeth->output_val.svalue.buf_addr + (pmeth->output_val.svalue.len_used + 5)), (void *) zstr.str.ch, (size_t) dsize);
+                  }
+                  pcon->p_isc_so->p_CacheExStrKill(&zstr);
+               }
+            }
+            if (full || rc != CACHE_SUCCESS) {
+               pmeth->output_val.svalue.len_used = node_offset;
+               break;
+            }
+         }
+         mg_add_block_size(&(pmeth->output_val.svalue), pmeth->output_val.svalue.len_used, (unsigned long) dsize, DBX_DSORT_DATA, DBX_DTYPE_DBXSTR);
+         pmeth->output_val.svalue.len_used += (dsize + 5);
+
+         nodes ++;
+      }
+   }
+
+   if (rc == CACHE_SUCCESS && full && nodes == 0) {
+      mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, "The output buffer is too small to hold the next node");
+      return rc;
+   }
+
+   mg_add_block_size(&(pmeth->output_val.svalue), 0, (unsigned long) (pmeth->output_val.svalue.len_used - 5), DBX_DSORT_DATA, DBX_DTYPE_DBXSTR);
+
+   return rc;
+}
+
+
 DBX_EXTFUN(int) dbx_delete(unsigned char *input, unsigned char *output)
 {
+   DBX_SESSION_CALL(dbx_delete, input, output);
    return dbx_delete_x(mg_unpack_header(input, output));
 }
 
 
 DBX_EXTFUN(int) dbx_delete_x(DBXMETH *pmeth)
 {
-   int rc;
+   int rc, cache_klen, cache_ttl;
+   unsigned char cache_key[DBX_MAXKEY];
    DBXCON *pcon;
 
    pcon = pmeth->pcon;
@@ -1195,7 +1826,11 @@ DBX_EXTFUN(int) dbx_delete_x(DBXMETH *pmeth)
       return 1;
    }
 
+   /* v1.3.19 */
+   cache_klen = mg_cache_key(pmeth, cache_key, DBX_MAXKEY, 0, &cache_ttl);
+
    DBX_LOCK(rc, 0);
+   DBX_WBUF_FLUSH(pcon); /* v1.3.20 */
 
    if (pcon->connected == 2) {
       strcpy(pmeth->command, "K");
@@ -1231,6 +1866,12 @@ DBX_EXTFUN(int) dbx_delete_x(DBXMETH *pmeth)
 
 dbx_delete_exit:
 
+   if (cache_klen) { /* v1.3.19 */
+      mg_enter_critical_section((void *) &dbx_global_mutex);
+      mg_cache_invalidate(cache_key, cache_klen, 1);
+      mg_leave_critical_section((void *) &dbx_global_mutex);
+   }
+
    DBX_UNLOCK(rc);
 
    mg_cleanup(pmeth);
@@ -1268,6 +1909,7 @@ DBX_EXTFUN(int) dbx_delete_ex(DBXMETH *pmeth)
 
 DBX_EXTFUN(int) dbx_defined(unsigned char *input, unsigned char *output)
 {
+   DBX_SESSION_CALL(dbx_defined, input, output);
    return dbx_defined_x(mg_unpack_header(input, output));
 }
 
@@ -1285,6 +1927,7 @@ DBX_EXTFUN(int) dbx_defined_x(DBXMETH *pmeth)
    }
 
    DBX_LOCK(rc, 0);
+   DBX_WBUF_FLUSH(pcon); /* v1.3.20 */
 
    if (pcon->connected == 2) {
       strcpy(pmeth->command, "D");
@@ -1357,13 +2000,15 @@ DBX_EXTFUN(int) dbx_defined_ex(DBXMETH *pmeth)
 
 DBX_EXTFUN(int) dbx_increment(unsigned char *input, unsigned char *output)
 {
+   DBX_SESSION_CALL(dbx_increment, input, output);
    return dbx_increment_x(mg_unpack_header(input, output));
 }
 
 
 DBX_EXTFUN(int) dbx_increment_x(DBXMETH *pmeth)
 {
-   int rc;
+   int rc, cache_klen, cache_ttl;
+   unsigned char cache_key[DBX_MAXKEY];
    DBXCON *pcon;
 
    pcon = pmeth->pcon;
@@ -1373,7 +2018,11 @@ DBX_EXTFUN(int) dbx_increment_x(DBXMETH *pmeth)
       return 1;
    }
 
+   /* v1.3.19 */
+   cache_klen = mg_cache_key(pmeth, cache_key, DBX_MAXKEY, 1, &cache_ttl);
+
    DBX_LOCK(rc, 0);
+   DBX_WBUF_FLUSH(pcon); /* v1.3.20 */
 
    if (pcon->connected == 2) {
       strcpy(pmeth->command, "I");
@@ -1410,6 +2059,12 @@ DBX_EXTFUN(int) dbx_increment_x(DBXMETH *pmeth)
 
 dbx_increment_exit:
 
+   if (cache_klen) { /* v1.3.19 */
+      mg_enter_critical_section((void *) &dbx_global_mutex);
+      mg_cache_invalidate(cache_key, cache_klen, cache_ttl < 0 ? 1 : 0); /* v1.3.22: everything cached for the server if the namespace is not known */
+      mg_leave_critical_section((void *) &dbx_global_mutex);
+   }
+
    DBX_UNLOCK(rc);
 
    return 0;
@@ -1445,13 +2100,15 @@ DBX_EXTFUN(int) dbx_increment_ex(DBXMETH *pmeth)
 /* v1.3.16 */
 DBX_EXTFUN(int) dbx_merge(unsigned char *input, unsigned char *output)
 {
+   DBX_SESSION_CALL(dbx_merge, input, output);
    return dbx_merge_x(mg_unpack_header(input, output));
 }
 
 
 DBX_EXTFUN(int) dbx_merge_x(DBXMETH *pmeth)
 {
-   int rc;
+   int rc, cache_klen, cache_ttl;
+   unsigned char cache_key[DBX_MAXKEY];
    DBXCON *pcon;
 
    pcon = pmeth->pcon;
@@ -1461,7 +2118,11 @@ DBX_EXTFUN(int) dbx_merge_x(DBXMETH *pmeth)
       return 1;
    }
 
+   /* v1.3.19 */
+   cache_klen = mg_cache_key(pmeth, cache_key, DBX_MAXKEY, -1, &cache_ttl);
+
    DBX_LOCK(rc, 0);
+   DBX_WBUF_FLUSH(pcon); /* v1.3.20 */
 
    if (pcon->connected == 2) {
       strcpy(pmeth->command, "n"); /* CM TODO - implement in %zmgsis for legacy wire protocol */
@@ -1498,6 +2159,12 @@ DBX_EXTFUN(int) dbx_merge_x(DBXMETH *pmeth)
 
 dbx_merge_exit:
 
+   if (cache_klen) { /* v1.3.19 */
+      mg_enter_critical_section((void *) &dbx_global_mutex);
+      mg_cache_invalidate(cache_key, cache_klen, 1);
+      mg_leave_critical_section((void *) &dbx_global_mutex);
+   }
+
    DBX_UNLOCK(rc);
 
    return 0;
@@ -1697,13 +2364,14 @@ dbx_merge_ex_exit:
 /* v1.3.13 */
 DBX_EXTFUN(int) dbx_lock(unsigned char *input, unsigned char *output)
 {
+   DBX_SESSION_CALL(dbx_lock, input, output);
    return dbx_lock_x(mg_unpack_header(input, output));
 }
 
 
 DBX_EXTFUN(int) dbx_lock_x(DBXMETH *pmeth)
 {
-   int rc;
+   int rc, n;
    DBXCON *pcon;
 
    pcon = pmeth->pcon;
@@ -1714,10 +2382,23 @@ DBX_EXTFUN(int) dbx_lock_x(DBXMETH *pmeth)
    }
 
    DBX_LOCK(rc, 0);
+   DBX_WBUF_FLUSH(pcon); /* v1.3.20 */
 
    if (pcon->connected == 2) {
+      unsigned long long start;
+      int dsort, dtype;
+
+      start = mg_time_ms(); /* v1.3.22 */
+      mg_unpack_arguments(pmeth);
       strcpy(pmeth->command, "NO");
       rc = netx_tcp_command(pmeth, 0);
+      if (rc == CACHE_SUCCESS && mg_get_block_size(&(pmeth->output_val.svalue), 0, &dsort, &dtype) > 0 && dsort != DBX_DSORT_ERROR) {
+         n = (pmeth->output_val.svalue.buf_addr[5] == '1');
+         if (n && pmeth->argc > 1) {
+            mg_lock_held(pcon, mg_lock_hash(pmeth, 0, pmeth->argc - 2), 1);
+         }
+         mg_lock_stat(pcon, n, start, !n);
+      }
       goto dbx_lock_exit;
    }
 
@@ -1757,12 +2438,14 @@ dbx_lock_exit:
 
 DBX_EXTFUN(int) dbx_lock_ex(DBXMETH *pmeth)
 {
-   int rc, retval, timeout, locktype;
-   unsigned long long timeout_nsec;
+   int rc, retval, timeout, locktype, limited;
+   unsigned long long timeout_nsec, timeout_ms, start;
    char buffer[32];
 
    DBXCON *pcon = pmeth->pcon;
 
+   start = mg_time_ms(); /* v1.3.22 */
+
    if (pcon->dbtype == DBX_DBTYPE_YOTTADB) {
       timeout = -1;
       if (pmeth->args[pmeth->argc - 1].svalue.len_used < 16) {
@@ -1770,12 +2453,9 @@ DBX_EXTFUN(int) dbx_lock_ex(DBXMETH *pmeth)
          buffer[pmeth->args[pmeth->argc - 1].svalue.len_used] = '\0';
          timeout = (int) strtol(buffer, NULL, 10);
       }
-      timeout_nsec = 1000000000;
+      limited = mg_lock_timeout(pcon, timeout, &timeout_ms); /* v1.3.22 */
+      timeout_nsec = timeout_ms * 1000000;
 
-      if (timeout < 0)
-         timeout_nsec *= 3600;
-      else
-         timeout_nsec *= timeout;
       rc = pcon->p_ydb_so->p_ydb_lock_incr_s(timeout_nsec, &(pmeth->args[0].svalue), pmeth->argc - 2, &pmeth->yargs[0]);
       if (rc == YDB_OK) {
          retval = 1;
@@ -1783,7 +2463,7 @@ DBX_EXTFUN(int) dbx_lock_ex(DBXMETH *pmeth)
       }
       else if (rc == YDB_LOCK_TIMEOUT) {
          retval = 0;
-         rc = YDB_OK;
+         rc = limited ? DBX_DEADLINE_EXCEEDED : YDB_OK;
       }
       else {
          retval = 0;
@@ -1797,19 +2477,34 @@ DBX_EXTFUN(int) dbx_lock_ex(DBXMETH *pmeth)
       strncpy(buffer, pmeth->args[pmeth->argc - 1].svalue.buf_addr, pmeth->args[pmeth->argc - 1].svalue.len_used);
       buffer[pmeth->args[pmeth->argc - 1].svalue.len_used] = '\0';
       timeout = (int) strtol(buffer, NULL, 10);
+      limited = mg_lock_timeout(pcon, timeout, &timeout_ms); /* v1.3.22 */
+      if (limited) {
+         timeout = (int) ((timeout_ms + 999) / 1000); /* round up: the deadline decides whether the wait ends early */
+      }
       locktype = CACHE_INCREMENTAL_LOCK;
       rc =  pcon->p_isc_so->p_CacheAcquireLock(pmeth->argc - 2, locktype, timeout, &retval);
+      if (rc == CACHE_SUCCESS && !retval && limited) {
+         rc = DBX_DEADLINE_EXCEEDED;
+      }
       sprintf((pmeth->output_val.svalue.buf_addr + 5), "%d", retval);
       pmeth->output_val.svalue.len_used = (unsigned int) strlen((pmeth->output_val.svalue.buf_addr + 5));
       mg_add_block_size(&(pmeth->output_val.svalue), 0, (unsigned long) pmeth->output_val.svalue.len_used, DBX_DSORT_DATA, DBX_DTYPE_DBXSTR);
    }
 
+   if (rc == CACHE_SUCCESS || rc == DBX_DEADLINE_EXCEEDED) {
+      if (retval) {
+         mg_lock_held(pcon, mg_lock_hash(pmeth, 0, pmeth->argc - 2), 1);
+      }
+      mg_lock_stat(pcon, retval ? 1 : 0, start, !retval);
+   }
+
    return rc;
 }
 
 
 DBX_EXTFUN(int) dbx_unlock(unsigned char *input, unsigned char *output)
 {
+   DBX_SESSION_CALL(dbx_unlock, input, output);
    return dbx_unlock_x(mg_unpack_header(input, output));
 }
 
@@ -1827,10 +2522,19 @@ DBX_EXTFUN(int) dbx_unlock_x(DBXMETH *pmeth)
    }
 
    DBX_LOCK(rc, 0);
+   DBX_WBUF_FLUSH(pcon); /* v1.3.20 */
 
    if (pcon->connected == 2) {
+      int dsort, dtype;
+
+      mg_unpack_arguments(pmeth);
       strcpy(pmeth->command, "NO");
       rc = netx_tcp_command(pmeth, 0);
+      if (rc == CACHE_SUCCESS && mg_get_block_size(&(pmeth->output_val.svalue), 0, &dsort, &dtype) > 0 && dsort != DBX_DSORT_ERROR && pmeth->output_val.svalue.buf_addr[5] == '1') {
+         if (pmeth->argc > 0 && mg_lock_held(pcon, mg_lock_hash(pmeth, 0, pmeth->argc - 1), 0)) {
+            mg_lock_stat(pcon, -1, 0, 0); /* v1.3.22 */
+         }
+      }
       goto dbx_unlock_exit;
    }
 
@@ -1895,10 +2599,344 @@ DBX_EXTFUN(int) dbx_unlock_ex(DBXMETH *pmeth)
       mg_add_block_size(&(pmeth->output_val.svalue), 0, (unsigned long) pmeth->output_val.svalue.len_used, DBX_DSORT_DATA, DBX_DTYPE_DBXSTR);
    }
 
+   if (retval && mg_lock_held(pcon, mg_lock_hash(pmeth, 0, pmeth->argc - 1), 0)) { /* v1.3.22: count only the release of a lock taken through this connection */
+      mg_lock_stat(pcon, -1, 0, 0);
+   }
+
+   return rc;
+}
+
+
+/* v1.3.22: lock a list of global nodes
+   Each node is given as a global name (DBX_DSORT_GLOBAL) followed by its subscripts (DBX_DSORT_SUBSCRIPT).
+   The last item is the timeout (DBX_DSORT_DATA) which applies to the whole list: either all the nodes are locked or none are.
+*/
+DBX_EXTFUN(int) dbx_lock_many(unsigned char *input, unsigned char *output)
+{
+   DBX_SESSION_CALL(dbx_lock_many, input, output);
+   return dbx_lock_many_x(mg_unpack_header(input, output));
+}
+
+
+DBX_EXTFUN(int) dbx_lock_many_x(DBXMETH *pmeth)
+{
+   int rc;
+   DBXCON *pcon;
+
+   pcon = pmeth->pcon;
+
+   if (!pcon || !pcon->connected) {
+      mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, "No Database Connection");
+      return 1;
+   }
+
+   mg_unpack_arguments(pmeth);
+
+   DBX_LOCK(rc, 0);
+   DBX_WBUF_FLUSH(pcon);
+
+   if (pcon->connected == 2) { /* errors are returned by the server */
+      rc = dbx_lock_many_ex(pmeth);
+      if (rc == DBX_DEADLINE_EXCEEDED) { /* v1.3.22 */
+         mg_error_message(pmeth, rc);
+      }
+      goto dbx_lock_many_exit;
+   }
+
+   if (pcon->dbtype == DBX_DBTYPE_YOTTADB && pcon->tlevel > 0) {
+      pmeth->p_dbxfun = (int (*) (struct tagDBXMETH * pmeth)) dbx_lock_many_ex;
+      rc = ydb_transaction_task(pmeth, YDB_TPCTX_DB);
+   }
+   else {
+      rc = dbx_lock_many_ex(pmeth);
+   }
+
+   if (rc != CACHE_SUCCESS) {
+      mg_error_message(pmeth, rc);
+   }
+
+dbx_lock_many_exit:
+
+   DBX_UNLOCK(rc);
+
+   return 0;
+}
+
+
+DBX_EXTFUN(int) dbx_lock_many_ex(DBXMETH *pmeth)
+{
+   int rc, n, nnodes, timeout, remaining, retval, ok, held, limited, wait;
+   int nodes[DBX_MAXARGS], nsubs[DBX_MAXARGS];
+   unsigned long long start, timeout_ms, timeout_nsec;
+   char buffer[32];
+   DBXCON *pcon = pmeth->pcon;
+
+   rc = CACHE_SUCCESS;
+   retval = 0;
+   start = mg_time_ms();
+
+   timeout = -1;
+   if (pmeth->argc > 0 && pmeth->args[pmeth->argc - 1].sort == DBX_DSORT_DATA && pmeth->args[pmeth->argc - 1].svalue.len_used < 16) {
+      strncpy(buffer, pmeth->args[pmeth->argc - 1].svalue.buf_addr, pmeth->args[pmeth->argc - 1].svalue.len_used);
+      buffer[pmeth->args[pmeth->argc - 1].svalue.len_used] = '\0';
+      timeout = (int) strtol(buffer, NULL, 10);
+   }
+
+   nnodes = mg_lock_list(pmeth, nodes, nsubs, DBX_MAXARGS);
+
+   n = -1; /* not locked in one step */
+   limited = mg_lock_timeout(pcon, timeout, &timeout_ms);
+
+   if (pcon->connected != 2 && pcon->dbtype != DBX_DBTYPE_YOTTADB && nnodes > 0
+         && pcon->p_isc_so->p_CacheExecuteA && pcon->p_isc_so->p_CacheEvalA && pcon->p_isc_so->p_CacheConvert) {
+      CACHE_ASTR cmd;
+
+      /* One incremental LOCK command for the whole list: the database locks either all of the nodes or none of them */
+      wait = limited ? (int) ((timeout_ms + 999) / 1000) : timeout;
+      if (isc_lock_command(pmeth, nodes, nsubs, nnodes, wait, &cmd)) {
+         rc = pcon->p_isc_so->p_CacheExecuteA(&cmd);
+         if (rc == CACHE_SUCCESS) {
+            strcpy((char *) cmd.str, "$T");
+            cmd.len = 2;
+            rc = pcon->p_isc_so->p_CacheEvalA(&cmd);
+         }
+         if (rc == CACHE_SUCCESS) {
+            cmd.len = 256;
+            rc = pcon->p_isc_so->p_CacheConvert(CACHE_ASTRING, &cmd);
+            retval = (rc == CACHE_SUCCESS && cmd.len == 1 && cmd.str[0] == '1');
+         }
+         n = nnodes;
+      }
+   }
+   else if (pcon->connected != 2 && pcon->dbtype == DBX_DBTYPE_YOTTADB && nnodes > 0 && nnodes <= DBX_YLOCK_MAX
+            && pcon->p_ydb_so->p_ydb_lock_s && pcon->lstat.nnodes == 0) {
+      ydb_buffer_t *pvar[DBX_YLOCK_MAX], *psub[DBX_YLOCK_MAX];
+      int nsub[DBX_YLOCK_MAX];
+
+      /* No other locks are held through this connection, so acquire the whole list in one step with ydb_lock_s() - which releases any locks already held */
+      for (n = 0; n < DBX_YLOCK_MAX; n ++) {
+         pvar[n] = (n < nnodes) ? &(pmeth->yargs[nodes[n]]) : NULL;
+         psub[n] = (n < nnodes) ? &(pmeth->yargs[nodes[n] + 1]) : NULL;
+         nsub[n] = (n < nnodes) ? nsubs[n] : 0;
+      }
+      timeout_nsec = timeout_ms * 1000000;
+
+      rc = pcon->p_ydb_so->p_ydb_lock_s(timeout_nsec, nnodes, DBX_YLOCK_ARGS(0), DBX_YLOCK_ARGS(1), DBX_YLOCK_ARGS(2), DBX_YLOCK_ARGS(3), DBX_YLOCK_ARGS(4), DBX_YLOCK_ARGS(5),
+                                        DBX_YLOCK_ARGS(6), DBX_YLOCK_ARGS(7), DBX_YLOCK_ARGS(8), DBX_YLOCK_ARGS(9), DBX_YLOCK_ARGS(10));
+      if (rc == YDB_OK) {
+         retval = 1;
+      }
+      else if (rc == YDB_LOCK_TIMEOUT) {
+         rc = YDB_OK;
+      }
+      else {
+         rc = CACHE_FAILURE;
+      }
+      n = nnodes;
+   }
+
+   if (n == nnodes) {
+      if (rc == CACHE_SUCCESS && !retval && limited) {
+         rc = DBX_DEADLINE_EXCEEDED;
+      }
+      held = 0;
+      if (rc == CACHE_SUCCESS && retval) {
+         for (n = 0; n < nnodes; n ++) {
+            mg_lock_held(pcon, mg_lock_hash(pmeth, nodes[n], nsubs[n]), 1);
+         }
+         held = nnodes;
+      }
+      goto dbx_lock_many_ex_exit;
+   }
+
+   /* Otherwise lock the nodes in turn within the overall timeout, releasing those already locked if one can't be */
+   for (n = 0; n < nnodes; n ++) {
+      remaining = timeout;
+      if (timeout > 0) {
+         remaining = timeout - (int) ((mg_time_ms() - start) / 1000);
+         if (remaining < 0) {
+            remaining = 0;
+         }
+      }
+      rc = mg_lock_node(pmeth, nodes[n], nsubs[n], 1, remaining, &retval);
+      if (rc != CACHE_SUCCESS || !retval) {
+         break;
+      }
+      mg_lock_held(pcon, mg_lock_hash(pmeth, nodes[n], nsubs[n]), 1);
+   }
+   held = nnodes;
+   if (n < nnodes) {
+      retval = 0;
+      held = 0;
+      while (n -- > 0) {
+         mg_lock_node(pmeth, nodes[n], nsubs[n], 0, 0, &ok);
+         if (ok) {
+            mg_lock_held(pcon, mg_lock_hash(pmeth, nodes[n], nsubs[n]), 0);
+         }
+         else { /* could not be released so is still held */
+            held ++;
+         }
+      }
+   }
+
+dbx_lock_many_ex_exit:
+
+   if (rc == DBX_DEADLINE_EXCEEDED) {
+      mg_lock_stat(pcon, held, start, 1);
+   }
+   if (rc != CACHE_SUCCESS) {
+      return rc;
+   }
+
+   mg_lock_stat(pcon, held, start, !retval);
+
+   sprintf((pmeth->output_val.svalue.buf_addr + 5), "%d", retval);
+   pmeth->output_val.svalue.len_used = (unsigned int) strlen((pmeth->output_val.svalue.buf_addr + 5));
+   mg_add_block_size(&(pmeth->output_val.svalue), 0, (unsigned long) pmeth->output_val.svalue.len_used, DBX_DSORT_DATA, DBX_DTYPE_DBXSTR);
+
+   return rc;
+}
+
+
+/* v1.3.22: unlock a list of global nodes, given as for dbx_lock_many() but without the timeout */
+DBX_EXTFUN(int) dbx_unlock_many(unsigned char *input, unsigned char *output)
+{
+   DBX_SESSION_CALL(dbx_unlock_many, input, output);
+   return dbx_unlock_many_x(mg_unpack_header(input, output));
+}
+
+
+DBX_EXTFUN(int) dbx_unlock_many_x(DBXMETH *pmeth)
+{
+   int rc;
+   DBXCON *pcon;
+
+   pcon = pmeth->pcon;
+
+   if (!pcon || !pcon->connected) {
+      mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, "No Database Connection");
+      return 1;
+   }
+
+   mg_unpack_arguments(pmeth);
+
+   DBX_LOCK(rc, 0);
+   DBX_WBUF_FLUSH(pcon);
+
+   if (pcon->connected == 2) {
+      rc = dbx_unlock_many_ex(pmeth);
+      goto dbx_unlock_many_exit;
+   }
+
+   if (pcon->dbtype == DBX_DBTYPE_YOTTADB && pcon->tlevel > 0) {
+      pmeth->p_dbxfun = (int (*) (struct tagDBXMETH * pmeth)) dbx_unlock_many_ex;
+      rc = ydb_transaction_task(pmeth, YDB_TPCTX_DB);
+   }
+   else {
+      rc = dbx_unlock_many_ex(pmeth);
+   }
+
+   if (rc != CACHE_SUCCESS) {
+      mg_error_message(pmeth, rc);
+   }
+
+dbx_unlock_many_exit:
+
+   DBX_UNLOCK(rc);
+
+   return 0;
+}
+
+
+DBX_EXTFUN(int) dbx_unlock_many_ex(DBXMETH *pmeth)
+{
+   int rc, n, nnodes, nreleased, nunlocked, retval;
+   int nodes[DBX_MAXARGS], nsubs[DBX_MAXARGS];
+   DBXCON *pcon = pmeth->pcon;
+
+   nnodes = mg_lock_list(pmeth, nodes, nsubs, DBX_MAXARGS);
+
+   nreleased = 0;
+   nunlocked = 0;
+   rc = CACHE_SUCCESS;
+   for (n = 0; n < nnodes; n ++) {
+      rc = mg_lock_node(pmeth, nodes[n], nsubs[n], 0, 0, &retval);
+      if (rc != CACHE_SUCCESS) {
+         break;
+      }
+      if (retval) {
+         nreleased ++;
+         /* The database reports success for a node that was not locked, so count only the locks taken through this connection */
+         if (mg_lock_held(pcon, mg_lock_hash(pmeth, nodes[n], nsubs[n]), 0)) {
+            nunlocked ++;
+         }
+      }
+   }
+   mg_lock_stat(pcon, -nunlocked, 0, 0);
+
+   if (rc != CACHE_SUCCESS) {
+      return rc;
+   }
+
+   retval = (nreleased == nnodes);
+   sprintf((pmeth->output_val.svalue.buf_addr + 5), "%d", retval);
+   pmeth->output_val.svalue.len_used = (unsigned int) strlen((pmeth->output_val.svalue.buf_addr + 5));
+   mg_add_block_size(&(pmeth->output_val.svalue), 0, (unsigned long) pmeth->output_val.svalue.len_used, DBX_DSORT_DATA, DBX_DTYPE_DBXSTR);
+
    return rc;
 }
 
 
+/* v1.3.22: return (and optionally reset) the lock statistics for a connection */
+DBX_EXTFUN(int) dbx_lock_stats(unsigned char *input, unsigned char *output)
+{
+   int rc;
+   char buffer[512];
+   DBXMETH *pmeth;
+   DBXCON *pcon;
+   DBXLSTAT *pstat;
+
+   DBX_SESSION_CALL(dbx_lock_stats, input, output);
+
+   pmeth = mg_unpack_header(input, output);
+   pcon = pmeth->pcon;
+
+   if (!pcon || !pcon->connected) {
+      mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, "No Database Connection");
+      return 1;
+   }
+
+   mg_unpack_arguments(pmeth);
+
+   DBX_LOCK(rc, 0);
+
+   pstat = &(pcon->lstat);
+   sprintf(buffer, "locks=%lu; timeouts=%lu; wait_ms=%llu; wait_max_ms=%llu; holds=%lu; hold_ms=%llu; hold_max_ms=%llu; held=%d",
+                     pstat->locks, pstat->timeouts, pstat->wait_ms, pstat->wait_max, pstat->holds, pstat->hold_ms, pstat->hold_max, pstat->held);
+
+   if (pmeth->argc > 0 && pmeth->args[0].svalue.len_used > 0 && pmeth->args[0].svalue.buf_addr[0] == '1') { /* reset - but keep track of the locks still held */
+      DBXLSTAT held;
+
+      held = *pstat;
+      memset((void *) pstat, 0, sizeof(DBXLSTAT));
+      pstat->held = held.held;
+      pstat->nnodes = held.nnodes;
+      pstat->max_nodes = held.max_nodes;
+      pstat->p_nodes = held.p_nodes;
+      if (pstat->held > 0) {
+         pstat->hold_start = mg_time_ms();
+      }
+   }
+
+   rc = CACHE_SUCCESS;
+   mg_create_string(pmeth, (void *) buffer, DBX_DTYPE_STR);
+
+   DBX_UNLOCK(rc);
+
+   return 0;
+}
+
+
 /* v1.2.8 */
 DBX_EXTFUN(int) dbx_tstart(unsigned char *input, unsigned char *output)
 {
@@ -1906,6 +2944,8 @@ DBX_EXTFUN(int) dbx_tstart(unsigned char *input, unsigned char *output)
    DBXMETH *pmeth;
    DBXCON *pcon;
 
+   DBX_SESSION_CALL(dbx_tstart, input, output);
+
    pmeth = mg_unpack_header(input, output);
    pcon = pmeth->pcon;
 
@@ -1917,6 +2957,7 @@ DBX_EXTFUN(int) dbx_tstart(unsigned char *input, unsigned char *output)
    mg_unpack_arguments(pmeth);
 
    DBX_LOCK(rc, 0);
+   DBX_WBUF_FLUSH(pcon); /* v1.3.20 */
 
    if (pcon->connected == 2) {
       strcpy(pmeth->command, "a");
@@ -1973,6 +3014,8 @@ DBX_EXTFUN(int) dbx_tlevel(unsigned char *input, unsigned char *output)
    DBXMETH *pmeth;
    DBXCON *pcon;
 
+   DBX_SESSION_CALL(dbx_tlevel, input, output);
+
    pmeth = mg_unpack_header(input, output);
    pcon = pmeth->pcon;
 
@@ -2046,6 +3089,8 @@ DBX_EXTFUN(int) dbx_tcommit(unsigned char *input, unsigned char *output)
    DBXMETH *pmeth;
    DBXCON *pcon;
 
+   DBX_SESSION_CALL(dbx_tcommit, input, output);
+
    pmeth = mg_unpack_header(input, output);
    pcon = pmeth->pcon;
 
@@ -2057,6 +3102,7 @@ DBX_EXTFUN(int) dbx_tcommit(unsigned char *input, unsigned char *output)
    mg_unpack_arguments(pmeth);
 
    DBX_LOCK(rc, 0);
+   DBX_WBUF_FLUSH(pcon); /* v1.3.20 */
 
    if (pcon->connected == 2) {
       strcpy(pmeth->command, "c");
@@ -2119,6 +3165,8 @@ DBX_EXTFUN(int) dbx_trollback(unsigned char *input, unsigned char *output)
    DBXMETH *pmeth;
    DBXCON *pcon;
 
+   DBX_SESSION_CALL(dbx_trollback, input, output);
+
    pmeth = mg_unpack_header(input, output);
    pcon = pmeth->pcon;
 
@@ -2130,6 +3178,7 @@ DBX_EXTFUN(int) dbx_trollback(unsigned char *input, unsigned char *output)
    mg_unpack_arguments(pmeth);
 
    DBX_LOCK(rc, 0);
+   DBX_WBUF_FLUSH(pcon); /* v1.3.20 */
 
    if (pcon->connected == 2) {
       strcpy(pmeth->command, "d");
@@ -2188,6 +3237,7 @@ DBX_EXTFUN(int) dbx_trollback_ex(DBXMETH *pmeth)
 
 DBX_EXTFUN(int) dbx_function(unsigned char *input, unsigned char *output)
 {
+   DBX_SESSION_CALL(dbx_function, input, output);
    return dbx_function_x(mg_unpack_header(input, output));
 }
 
@@ -2208,6 +3258,7 @@ DBX_EXTFUN(int) dbx_function_x(DBXMETH *pmeth)
    fun.rflag = 0;
 
    DBX_LOCK(rc, 0);
+   DBX_WBUF_FLUSH(pcon); /* v1.3.20 */
 
    if (pcon->connected == 2) {
       strcpy(pmeth->command, "X");
@@ -2241,6 +3292,9 @@ DBX_EXTFUN(int) dbx_function_x(DBXMETH *pmeth)
 
 dbx_function_exit:
 
+   mg_namespace_set(pcon, NULL); /* v1.3.22: the M code run may have changed the namespace */
+   mg_function_cache_clear(pcon, 0); /* ... so the label^routine references resolved may no longer apply */
+
    DBX_UNLOCK(rc);
 
    return 0;
@@ -2275,6 +3329,7 @@ DBX_EXTFUN(int) dbx_function_ex(DBXMETH *pmeth)
 
 DBX_EXTFUN(int) dbx_classmethod(unsigned char *input, unsigned char *output)
 {
+   DBX_SESSION_CALL(dbx_classmethod, input, output);
    return dbx_classmethod_x(mg_unpack_header(input, output));
 }
 
@@ -2299,6 +3354,7 @@ DBX_EXTFUN(int) dbx_classmethod_x(DBXMETH *pmeth)
    }
 
    DBX_LOCK(rc, 0);
+   DBX_WBUF_FLUSH(pcon); /* v1.3.20 */
 
    if (pcon->connected == 2) {
       strcpy(pmeth->command, "x");
@@ -2323,6 +3379,9 @@ DBX_EXTFUN(int) dbx_classmethod_x(DBXMETH *pmeth)
 
 dbx_classmethod_exit:
 
+   mg_namespace_set(pcon, NULL); /* v1.3.22: the M code run may have changed the namespace */
+   mg_function_cache_clear(pcon, 0); /* ... so the label^routine references resolved may no longer apply */
+
    DBX_UNLOCK(rc);
 
    return 0;
@@ -2331,6 +3390,7 @@ dbx_classmethod_exit:
 
 DBX_EXTFUN(int) dbx_method(unsigned char *input, unsigned char *output)
 {
+   DBX_SESSION_CALL(dbx_method, input, output);
    return dbx_method_x(mg_unpack_header(input, output));
 }
 
@@ -2355,6 +3415,7 @@ DBX_EXTFUN(int) dbx_method_x(DBXMETH *pmeth)
    }
 
    DBX_LOCK(rc, 0);
+   DBX_WBUF_FLUSH(pcon); /* v1.3.20 */
 
    if (pcon->connected == 2) {
       strcpy(pmeth->command, "*");
@@ -2379,6 +3440,9 @@ DBX_EXTFUN(int) dbx_method_x(DBXMETH *pmeth)
 
 dbx_method_exit:
 
+   mg_namespace_set(pcon, NULL); /* v1.3.22: the M code run may have changed the namespace */
+   mg_function_cache_clear(pcon, 0); /* ... so the label^routine references resolved may no longer apply */
+
    DBX_UNLOCK(rc);
 
    return 0;
@@ -2387,6 +3451,7 @@ dbx_method_exit:
 
 DBX_EXTFUN(int) dbx_getproperty(unsigned char *input, unsigned char *output)
 {
+   DBX_SESSION_CALL(dbx_getproperty, input, output);
    return dbx_getproperty_x(mg_unpack_header(input, output));
 }
 
@@ -2411,6 +3476,7 @@ DBX_EXTFUN(int) dbx_getproperty_x(DBXMETH *pmeth)
    }
 
    DBX_LOCK(rc, 0);
+   DBX_WBUF_FLUSH(pcon); /* v1.3.20 */
 
    if (pcon->connected == 2) {
       strcpy(pmeth->command, "*");
@@ -2447,6 +3513,8 @@ DBX_EXTFUN(int) dbx_setproperty(unsigned char *input, unsigned char *output)
    DBXMETH *pmeth;
    DBXCON *pcon;
 
+   DBX_SESSION_CALL(dbx_setproperty, input, output);
+
    pmeth = mg_unpack_header(input, output);
    pcon = pmeth->pcon;
 
@@ -2463,6 +3531,7 @@ DBX_EXTFUN(int) dbx_setproperty(unsigned char *input, unsigned char *output)
    }
 
    DBX_LOCK(rc, 0);
+   DBX_WBUF_FLUSH(pcon); /* v1.3.20 */
 
    if (pcon->connected == 2) {
       strcpy(pmeth->command, "*");
@@ -2493,14 +3562,24 @@ dbx_setproperty_exit:
 }
 
 
+/* v1.3.22: get a list of properties for an instantiated object in one call
+   Input: oref, name1, name2 ...
+   Output: the property values, each as a DBX_DSORT_DATA item, packed into a single block
+*/
+DBX_EXTFUN(int) dbx_getproperties(unsigned char *input, unsigned char *output)
+{
+   DBX_SESSION_CALL(dbx_getproperties, input, output);
+   return dbx_getproperties_x(mg_unpack_header(input, output));
+}
 
-DBX_EXTFUN(int) dbx_closeinstance(unsigned char *input, unsigned char *output)
+
+DBX_EXTFUN(int) dbx_getproperties_x(DBXMETH *pmeth)
 {
-   int rc;
-   DBXMETH *pmeth;
+   int rc, n, oref, full;
+   unsigned int max, len;
+   CACHE_EXSTR zstr;
    DBXCON *pcon;
 
-   pmeth = mg_unpack_header(input, output);
    pcon = pmeth->pcon;
 
    if (!pcon || !pcon->connected) {
@@ -2515,40 +3594,356 @@ DBX_EXTFUN(int) dbx_closeinstance(unsigned char *input, unsigned char *output)
       return 0;
    }
 
-   DBX_LOCK(rc, 0);
-
-   if (pcon->connected == 2) {
-      strcpy(pmeth->command, "*");
-      rc = netx_tcp_command(pmeth, 0);
-      goto dbx_closeinstance_exit;
+   if (pcon->connected == 2) { /* the DB Server (%zmgsi) has no command for this */
+      mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, "Batch property access is not available over network-based connectivity");
+      return 1;
    }
 
-   /* v1.3.13 */
-   rc = mg_class_reference(pmeth, 3);
+   DBX_LOCK(rc, 0);
+   DBX_WBUF_FLUSH(pcon);
 
-   if (rc == CACHE_SUCCESS) {
-      mg_create_string(pmeth, (void *) "", DBX_DTYPE_STR);
-   }
-   else {
-      mg_error_message(pmeth, rc);
-   }
+   mg_unpack_arguments(pmeth);
 
-dbx_closeinstance_exit:
+   max = 0;
+   if (pmeth->output_val.svalue.len_alloc > 8) {
+      max = (pmeth->output_val.svalue.len_alloc - 7); /* 5 Byte header plus 2 spare */
+   }
+   pmeth->output_val.svalue.len_used = 5;
+   pmeth->output_val.offset = 5;
 
-   DBX_UNLOCK(rc);
+   rc = CACHE_SUCCESS;
+   full = 0;
+   oref = 0;
+   if (pmeth->argc > 0) {
+      oref = (int) strtol(pmeth->args[0].svalue.buf_addr, NULL, 10);
+   }
+
+   for (n = 1; n < pmeth->argc; n ++) {
+      rc = pcon->p_isc_so->p_CachePushProperty(oref, pmeth->args[n].svalue.len_used, (const Callin_char_t *) pmeth->args[n].svalue.buf_addr);
+      if (rc == CACHE_SUCCESS) {
+         rc = pcon->p_isc_so->p_CacheGetProperty();
+      }
+      if (rc != CACHE_SUCCESS) {
+         break;
+      }
+
+      if (pcon->p_isc_so->p_CacheType && pcon->p_isc_so->p_CacheType() == CACHE_OREF) {
+         unsigned int oref_value;
+         char buffer[32];
+
+         rc = pcon->p_isc_so->p_CachePopOref(&oref_value);
+         if (rc != CACHE_SUCCESS) {
+            break;
+         }
+         if (mg_oref_add(pcon, (int) oref_value) > 1) {
+            pcon->p_isc_so->p_CacheCloseOref((int) oref_value);
+         }
+         sprintf(buffer, "%u", oref_value);
+         len = (unsigned int) strlen(buffer);
+         if ((pmeth->output_val.svalue.len_used + len + 5) > max) {
+            full = 1;
+            break;
+         }
+         mg_add_block_size(&(pmeth->output_val.svalue), pmeth->output_val.svalue.len_used, (unsigned long) len, DBX_DSORT_DATA, DBX_DTYPE_OREF);
+         memcpy((void *) (pmeth->output_val.svalue.buf_addr + pmeth->output_val.svalue.len_used + 5), (void *) buffer, (size_t) len);
+         pmeth->output_val.svalue.len_used += (len + 5);
+         continue;
+      }
+
+      zstr.len = 0;
+      zstr.str.ch = NULL;
+      rc = pcon->p_isc_so->p_CachePopExStr(&zstr);
+      if (rc != CACHE_SUCCESS) {
+         break;
+      }
+      len = zstr.len;
+      if ((pmeth->output_val.svalue.len_used + len + 5) > max) {
+         pcon->p_isc_so->p_CacheExStrKill(&zstr);
+         full = 1;
+         break;
+      }
+      mg_add_block_size(&(pmeth->output_val.svalue), pmeth->output_val.svalue.len_used, (unsigned long) len, DBX_DSORT_DATA, DBX_DTYPE_DBXSTR);
+      memcpy((void *) (pmeth->output_val.svalue.buf_addr + pmeth->output_val.svalue.len_used + 5), (void *) zstr.str.ch, (size_t) len);
+      pmeth->output_val.svalue.len_used += (len + 5);
+      pcon->p_isc_so->p_CacheExStrKill(&zstr);
+   }
+
+   if (full) {
+      pmeth->output_val.svalue.len_used = 5;
+      mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, "The output buffer is too small to hold the properties");
+      goto dbx_getproperties_exit;
+   }
+   if (rc != CACHE_SUCCESS) {
+      pmeth->output_val.svalue.len_used = 5;
+      mg_error_message(pmeth, rc);
+      goto dbx_getproperties_exit;
+   }
+
+   mg_add_block_size(&(pmeth->output_val.svalue), 0, (unsigned long) (pmeth->output_val.svalue.len_used - 5), DBX_DSORT_DATA, DBX_DTYPE_DBXSTR);
+
+dbx_getproperties_exit:
+
+   DBX_UNLOCK(rc);
 
    return 0;
 }
 
 
-DBX_EXTFUN(int) dbx_getnamespace(unsigned char *input, unsigned char *output)
+/* v1.3.22: set a list of properties for an instantiated object in one call
+   Input: oref, name1, value1, name2, value2 ...
+   Output: the number of properties set
+*/
+DBX_EXTFUN(int) dbx_setproperties(unsigned char *input, unsigned char *output)
+{
+   DBX_SESSION_CALL(dbx_setproperties, input, output);
+   return dbx_setproperties_x(mg_unpack_header(input, output));
+}
+
+
+DBX_EXTFUN(int) dbx_setproperties_x(DBXMETH *pmeth)
+{
+   int rc, n, oref, count;
+   char buffer[32];
+   DBXCON *pcon;
+
+   pcon = pmeth->pcon;
+
+   if (!pcon || !pcon->connected) {
+      mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, "No Database Connection");
+      return 1;
+   }
+
+   if (pcon->dbtype == DBX_DBTYPE_YOTTADB) {
+      pcon->error_code = 2020;
+      strcpy(pcon->error, "Cache objects are not available with this platform");
+      mg_set_error_message(pmeth);
+      return 0;
+   }
+
+   if (pcon->connected == 2) { /* the DB Server (%zmgsi) has no command for this */
+      mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, "Batch property access is not available over network-based connectivity");
+      return 1;
+   }
+
+   DBX_LOCK(rc, 0);
+   DBX_WBUF_FLUSH(pcon);
+
+   mg_unpack_arguments(pmeth);
+
+   rc = CACHE_SUCCESS;
+   count = 0;
+   oref = 0;
+   if (pmeth->argc > 0) {
+      oref = (int) strtol(pmeth->args[0].svalue.buf_addr, NULL, 10);
+   }
+
+   for (n = 1; (n + 1) < pmeth->argc; n += 2) {
+      rc = pcon->p_isc_so->p_CachePushProperty(oref, pmeth->args[n].svalue.len_used, (const Callin_char_t *) pmeth->args[n].svalue.buf_addr);
+      if (rc == CACHE_SUCCESS) {
+         rc = isc_push_value(pcon, &(pmeth->args[n + 1]));
+      }
+      if (rc == CACHE_SUCCESS) {
+         rc = pcon->p_isc_so->p_CacheSetProperty();
+      }
+      if (rc != CACHE_SUCCESS) {
+         break;
+      }
+      count ++;
+   }
+
+   if (rc == CACHE_SUCCESS) {
+      sprintf(buffer, "%d", count);
+      mg_create_string(pmeth, (void *) buffer, DBX_DTYPE_STR);
+   }
+   else {
+      mg_error_message(pmeth, rc);
+   }
+
+   mg_cleanup(pmeth); /* release any long strings pushed for the values */
+
+   DBX_UNLOCK(rc);
+
+   return 0;
+}
+
+
+
+DBX_EXTFUN(int) dbx_closeinstance(unsigned char *input, unsigned char *output)
 {
    int rc;
+   DBXMETH *pmeth;
+   DBXCON *pcon;
+
+   DBX_SESSION_CALL(dbx_closeinstance, input, output);
+
+   pmeth = mg_unpack_header(input, output);
+   pcon = pmeth->pcon;
+
+   if (!pcon || !pcon->connected) {
+      mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, "No Database Connection");
+      return 1;
+   }
+
+   if (pcon->dbtype == DBX_DBTYPE_YOTTADB) {
+      pcon->error_code = 2020;
+      strcpy(pcon->error, "Cache objects are not available with this platform");
+      mg_set_error_message(pmeth);
+      return 0;
+   }
+
+   DBX_LOCK(rc, 0);
+
+   if (pcon->connected == 2) {
+      strcpy(pmeth->command, "*");
+      rc = netx_tcp_command(pmeth, 0);
+      goto dbx_closeinstance_exit;
+   }
+
+   /* v1.3.13 */
+   rc = mg_class_reference(pmeth, 3);
+
+   if (rc == CACHE_SUCCESS) {
+      mg_create_string(pmeth, (void *) "", DBX_DTYPE_STR);
+   }
+   else {
+      mg_error_message(pmeth, rc);
+   }
+
+dbx_closeinstance_exit:
+
+   DBX_UNLOCK(rc);
+
+   return 0;
+}
+
+
+/* v1.3.22: release a list of OREFs in one call
+   Input: oref1, oref2 ...
+   Output: the number of objects closed on the server (those for which the last reference was released)
+*/
+DBX_EXTFUN(int) dbx_closeinstances(unsigned char *input, unsigned char *output)
+{
+   DBX_SESSION_CALL(dbx_closeinstances, input, output);
+   return dbx_closeinstances_x(mg_unpack_header(input, output));
+}
+
+
+DBX_EXTFUN(int) dbx_closeinstances_x(DBXMETH *pmeth)
+{
+   int rc, n, oref, closed, argc, len;
+   int orefs[DBX_MAXARGS];
+   char buffer[32];
+   unsigned char request[64];
+   char *input;
+   DBXCON *pcon;
+
+   pcon = pmeth->pcon;
+
+   if (!pcon || !pcon->connected) {
+      mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, "No Database Connection");
+      return 1;
+   }
+
+   if (pcon->dbtype == DBX_DBTYPE_YOTTADB) {
+      pcon->error_code = 2020;
+      strcpy(pcon->error, "Cache objects are not available with this platform");
+      mg_set_error_message(pmeth);
+      return 0;
+   }
+
+   DBX_LOCK(rc, 0);
+   DBX_WBUF_FLUSH(pcon);
+
+   mg_unpack_arguments(pmeth);
+
+   rc = CACHE_SUCCESS;
+   closed = 0;
+
+   if (pcon->connected == 2) {
+      /* The DB Server (%zmgsi) has no command for a list, so close the objects one at a time.  The replies */
+      /* overwrite the input buffer so the OREFs and the request header are copied out of it first. */
+      /* An object the server cannot close has gone already so is skipped. */
+      argc = pmeth->argc;
+      for (n = 0; n < argc; n ++) {
+         orefs[n] = (int) strtol(pmeth->args[n].svalue.buf_addr, NULL, 10);
+      }
+      memcpy((void *) request, (void *) pmeth->input_str.buf_addr, 15);
+      input = pmeth->input_str.buf_addr;
+      pmeth->input_str.buf_addr = (char *) request;
+      strcpy(pmeth->command, "*");
+      for (n = 0; n < argc; n ++) {
+         if (orefs[n] < 1) {
+            continue;
+         }
+         sprintf(buffer, "%d", orefs[n]);
+         len = (int) strlen(buffer);
+         mg_set_size(request + 15, (unsigned long) len);
+         request[19] = (unsigned char) ((DBX_DSORT_DATA * 20) + DBX_DTYPE_STR);
+         memcpy((void *) (request + 20), (void *) buffer, (size_t) len);
+         mg_set_size(request + 20 + len, 0);
+         request[24 + len] = (unsigned char) ((DBX_DSORT_EOD * 20) + DBX_DTYPE_STR);
+         pmeth->input_str.len_used = (25 + len);
+         mg_set_size(request, (unsigned long) pmeth->input_str.len_used);
+         request[4] = (unsigned char) DBX_CMND_CCLOSE;
+
+         rc = netx_tcp_command(pmeth, 0);
+         if (rc != CACHE_SUCCESS) {
+            break;
+         }
+         if ((((unsigned char) pmeth->output_val.svalue.buf_addr[4]) / 20) != DBX_DSORT_ERROR) {
+            closed ++;
+         }
+      }
+      pmeth->input_str.buf_addr = input;
+      if (rc != CACHE_SUCCESS) {
+         goto dbx_closeinstances_exit;
+      }
+      pmeth->output_val.svalue.len_used = 5;
+      sprintf(buffer, "%d", closed);
+      mg_create_string(pmeth, (void *) buffer, DBX_DTYPE_STR);
+      goto dbx_closeinstances_exit;
+   }
+
+   for (n = 0; n < pmeth->argc; n ++) {
+      oref = (int) strtol(pmeth->args[n].svalue.buf_addr, NULL, 10);
+      if (oref < 1 || mg_oref_release(pcon, oref) != 0) { /* still referenced, or not held (already closed) */
+         continue;
+      }
+      rc = pcon->p_isc_so->p_CacheCloseOref(oref);
+      if (rc != CACHE_SUCCESS) {
+         mg_oref_add(pcon, oref); /* still held, so that it can be released again */
+         break;
+      }
+      closed ++;
+   }
+
+   if (rc == CACHE_SUCCESS) {
+      sprintf(buffer, "%d", closed);
+      mg_create_string(pmeth, (void *) buffer, DBX_DTYPE_STR);
+   }
+   else {
+      mg_error_message(pmeth, rc);
+   }
+
+dbx_closeinstances_exit:
+
+   DBX_UNLOCK(rc);
+
+   return 0;
+}
+
+
+DBX_EXTFUN(int) dbx_getnamespace(unsigned char *input, unsigned char *output)
+{
+   int rc, len, dsort, dtype;
+   char nspace[72];
    CACHE_ASTR retval;
    CACHE_ASTR expr;
    DBXMETH *pmeth;
    DBXCON *pcon;
 
+   DBX_SESSION_CALL(dbx_getnamespace, input, output);
+
    pmeth = mg_unpack_header(input, output);
    pcon = pmeth->pcon;
 
@@ -2581,15 +3976,35 @@ DBX_EXTFUN(int) dbx_getnamespace(unsigned char *input, unsigned char *output)
    if (pcon->connected == 2) {
       strcpy(pmeth->command, "gns");
       rc = netx_tcp_command(pmeth, 0);
+      if (rc == CACHE_SUCCESS) { /* v1.3.22: record the namespace reported by the server */
+         len = (int) mg_get_block_size(&(pmeth->output_val.svalue), 0, &dsort, &dtype);
+         if (dsort == DBX_DSORT_DATA && len > 0 && len < (int) sizeof(nspace)) {
+            memcpy((void *) nspace, (void *) (pmeth->output_val.svalue.buf_addr + 5), (size_t) len);
+            nspace[len] = '\0';
+            mg_namespace_set(pcon, nspace);
+         }
+      }
       goto dbx_getnamespace_exit;
    }
 
-   rc = pcon->p_isc_so->p_CacheEvalA(&expr);
+   if (pcon->cur_nspace[0]) { /* v1.3.22 */
+      retval.len = (unsigned short) strlen(pcon->cur_nspace);
+      strcpy((char *) retval.str, pcon->cur_nspace);
+      rc = CACHE_SUCCESS;
+   }
+   else {
+      rc = pcon->p_isc_so->p_CacheEvalA(&expr);
+      if (rc == CACHE_SUCCESS) {
+         retval.len = 256;
+         rc = pcon->p_isc_so->p_CacheConvert(CACHE_ASTRING, &retval);
+         if (rc == CACHE_SUCCESS && retval.len > 0 && retval.len < (int) sizeof(pcon->cur_nspace)) {
+            memcpy((void *) pcon->cur_nspace, (void *) retval.str, retval.len);
+            pcon->cur_nspace[retval.len] = '\0';
+         }
+      }
+   }
 
    if (rc == CACHE_SUCCESS) {
-      retval.len = 256;
-      rc = pcon->p_isc_so->p_CacheConvert(CACHE_ASTRING, &retval);
-
       if (retval.len < pmeth->output_val.svalue.len_alloc) {
 
          strncpy((char *) pmeth->output_val.svalue.buf_addr + pmeth->output_val.offset, (char *) retval.str, retval.len);
@@ -2618,11 +4033,13 @@ dbx_getnamespace_exit:
 
 DBX_EXTFUN(int) dbx_setnamespace(unsigned char *input, unsigned char *output)
 {
-   int rc;
+   int rc, dsort, dtype;
    char nspace[128];
    DBXMETH *pmeth;
    DBXCON *pcon;
 
+   DBX_SESSION_CALL(dbx_setnamespace, input, output);
+
    pmeth = mg_unpack_header(input, output);
    pcon = pmeth->pcon;
 
@@ -2647,20 +4064,33 @@ DBX_EXTFUN(int) dbx_setnamespace(unsigned char *input, unsigned char *output)
 
    mg_unpack_arguments(pmeth);
 
-   if (pcon->connected == 2) {
-      strcpy(pmeth->command, "sns");
-      rc = netx_tcp_command(pmeth, 0);
-      goto dbx_setnamespace_exit;
-   }
-
-   DBX_LOCK(rc, 0);
-
    *nspace = '\0';
    if (pmeth->argc > 0 && pmeth->args[0].svalue.len_used < 120) {
       strncpy(nspace, (char *) pmeth->args[0].svalue.buf_addr, pmeth->args[0].svalue.len_used);
       nspace[pmeth->args[0].svalue.len_used] = '\0';
    }
 
+   DBX_LOCK(rc, 0);
+   DBX_WBUF_FLUSH(pcon); /* v1.3.20 */
+
+   if (pcon->connected == 2) {
+      strcpy(pmeth->command, "sns");
+      rc = netx_tcp_command(pmeth, 0);
+      if (rc == CACHE_SUCCESS) { /* v1.3.22: record the namespace the server has changed to */
+         mg_get_block_size(&(pmeth->output_val.svalue), 0, &dsort, &dtype);
+         mg_namespace_set(pcon, (dsort == DBX_DSORT_DATA) ? nspace : NULL);
+         if (dsort == DBX_DSORT_DATA && strlen(nspace) < sizeof(pcon->nspace)) { /* ... and open standby connections in it */
+            mg_enter_critical_section((void *) &dbx_global_mutex);
+            strcpy(pcon->nspace, nspace);
+            if (pcon->p_stby) {
+               strcpy(((DBXSTBY *) pcon->p_stby)->nspace, nspace);
+            }
+            mg_leave_critical_section((void *) &dbx_global_mutex);
+         }
+      }
+      goto dbx_setnamespace_exit;
+   }
+
    rc = isc_change_namespace(pcon, nspace);
 
    if (rc == CACHE_SUCCESS) {
@@ -2697,14 +4127,402 @@ DBX_EXTFUN(int) dbx_sleep(int period_ms)
 }
 
 
-DBX_EXTFUN(int) dbx_benchmark(unsigned char *inputstr, unsigned char *outputstr)
+/* v1.3.22: set a deadline for the requests made through a connection
+   period_ms > 0: requests must complete within period_ms of now
+   period_ms = 0: no deadline
+   period_ms < 0: the deadline has already passed - a request in progress (in another thread) returns as soon as it can
+*/
+DBX_EXTFUN(int) dbx_deadline(int index, int period_ms)
 {
-   strcpy((char *) inputstr, "Output String");
-   return 0;
-}
+   DBXCON *pcon;
 
+   pcon = NULL;
+   if (index >= 0 && index < DBX_MAXCONS) {
+      pcon = connection[index];
+   }
+   if (!pcon) {
+      return -1;
+   }
 
-int isc_load_library(DBXCON *pcon)
+   if (period_ms > 0) {
+      pcon->deadline = mg_time_ms() + (unsigned long long) period_ms;
+   }
+   else if (period_ms < 0) {
+      pcon->deadline = 1;
+   }
+   else {
+      pcon->deadline = 0;
+   }
+
+   return 0;
+}
+
+
+DBX_EXTFUN(int) dbx_benchmark(unsigned char *inputstr, unsigned char *outputstr)
+{
+   if (!strncmp((char *) inputstr, "codec", 5)) { /* v1.3.22 */
+      return mg_benchmark_codec(inputstr);
+   }
+   strcpy((char *) inputstr, "Output String");
+   return 0;
+}
+
+
+/* v1.3.22: time 'codec <n>' cycles of the chunk size and item header codecs: the result replaces the input */
+int mg_benchmark_codec(unsigned char *inputstr)
+{
+   int n, size, len, cycles, errors;
+   short byref, type;
+   unsigned long long start, elapsed;
+   unsigned char esize[32], head[MG_ITEM_HEAD_MAX];
+
+   cycles = 0;
+   for (n = 5; inputstr[n] == ' '; n ++)
+      ;
+   for (; inputstr[n] >= '0' && inputstr[n] <= '9' && cycles < 100000000; n ++) {
+      cycles = (cycles * 10) + (inputstr[n] - '0');
+   }
+   if (cycles < 1) {
+      cycles = 1000000;
+   }
+
+   errors = 0;
+   start = mg_time_ms();
+   for (n = 0; n < cycles; n ++) {
+      size = (int) ((((unsigned int) n * 2654435761U) & 0x7fffffff) >> (n % 31)); /* sizes of all lengths */
+      len = mg_encode_size(esize, size, MG_CHUNK_SIZE_BASE);
+      errors += (mg_decode_size(esize, len, MG_CHUNK_SIZE_BASE) != size);
+      len = mg_encode_size(esize, size, 10);
+      errors += (mg_decode_size(esize, len, 10) != size);
+      size %= 10000000; /* item headers hold up to 7 digits */
+      mg_encode_item_header(head, size, 0, DBX_DTYPE_STR);
+      mg_decode_item_header(head, &len, &byref, &type);
+      errors += (len != size || type != DBX_DTYPE_STR);
+   }
+   elapsed = mg_time_ms() - start;
+
+   sprintf((char *) inputstr, "codec: %d cycles in %llu ms (%llu ns per cycle); %d errors", cycles, elapsed, (elapsed * 1000000) / (unsigned long long) cycles, errors);
+
+   return 0;
+}
+
+
+/* v1.3.19 */
+DBX_EXTFUN(int) dbx_cache_global(char *global, int ttl)
+{
+   int n, len, result;
+
+   if (!global) {
+      return -1;
+   }
+   if (global[0] == '^') {
+      global ++;
+   }
+   len = (int) strlen(global);
+   if (len < 1 || len > 63) {
+      return -1;
+   }
+
+   result = 0;
+   mg_enter_critical_section((void *) &dbx_global_mutex);
+
+   if (dbx_cache.max_entries == 0) {
+      dbx_cache.max_entries = DBX_CACHE_MAXENTRIES;
+      dbx_cache.max_size = DBX_CACHE_MAXSIZE;
+   }
+
+   for (n = 0; n < dbx_cache.globals; n ++) {
+      if (dbx_cache.global[n].name_len == len && !strncmp(dbx_cache.global[n].name, global, len)) {
+         break;
+      }
+   }
+
+   if (ttl > 0) {
+      if (n == dbx_cache.globals) {
+         if (n < DBX_CACHE_MAXGLOBALS) {
+            strcpy(dbx_cache.global[n].name, global);
+            dbx_cache.global[n].name_len = len;
+            dbx_cache.globals ++;
+            dbx_cache.generation ++; /* reads already under way must not be cached */
+         }
+         else {
+            result = -1;
+         }
+      }
+      if (result == 0) {
+         dbx_cache.global[n].ttl = ttl;
+      }
+   }
+   else if (n < dbx_cache.globals) {
+      dbx_cache.globals --;
+      for (; n < dbx_cache.globals; n ++) {
+         dbx_cache.global[n] = dbx_cache.global[n + 1];
+      }
+      mg_cache_invalidate(NULL, 0, 2);
+   }
+
+   mg_leave_critical_section((void *) &dbx_global_mutex);
+
+   return result;
+}
+
+
+DBX_EXTFUN(int) dbx_cache_limits(int max_entries, int max_size)
+{
+   mg_enter_critical_section((void *) &dbx_global_mutex);
+
+   dbx_cache.max_entries = (max_entries > 0) ? max_entries : DBX_CACHE_MAXENTRIES;
+   dbx_cache.max_size = (max_size > 0) ? (unsigned long) max_size : DBX_CACHE_MAXSIZE;
+
+   while (dbx_cache.plru_tail && (dbx_cache.entries > dbx_cache.max_entries || dbx_cache.size > dbx_cache.max_size)) {
+      mg_cache_remove(dbx_cache.plru_tail);
+   }
+
+   mg_leave_critical_section((void *) &dbx_global_mutex);
+
+   return 0;
+}
+
+
+DBX_EXTFUN(int) dbx_cache_clear(void)
+{
+   mg_enter_critical_section((void *) &dbx_global_mutex);
+   mg_cache_invalidate(NULL, 0, 2);
+   mg_leave_critical_section((void *) &dbx_global_mutex);
+
+   return 0;
+}
+
+
+/* v1.3.20 */
+DBX_EXTFUN(int) dbx_buffer(unsigned char *input, unsigned char *output)
+{
+   int rc, n, limit[3];
+   char buffer[32], error[DBX_ERROR_SIZE];
+   DBXMETH *pmeth;
+   DBXCON *pcon;
+   DBXWBUF *pwbuf;
+
+   DBX_SESSION_CALL(dbx_buffer, input, output);
+
+   pmeth = mg_unpack_header(input, output);
+   pcon = pmeth->pcon;
+
+   if (!pcon || !pcon->connected) {
+      mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, "No Database Connection");
+      return 1;
+   }
+
+   mg_unpack_arguments(pmeth);
+
+   /* Arguments: maximum number of nodes, maximum size (Bytes) and maximum age (ms) */
+   for (n = 0; n < 3; n ++) {
+      limit[n] = 0;
+      if (n < pmeth->argc && pmeth->args[n].svalue.len_used < 32) {
+         strncpy(buffer, pmeth->args[n].svalue.buf_addr, pmeth->args[n].svalue.len_used);
+         buffer[pmeth->args[n].svalue.len_used] = '\0';
+         limit[n] = (int) strtol(buffer, NULL, 10);
+      }
+   }
+
+   DBX_LOCK(rc, 0);
+
+   rc = CACHE_SUCCESS;
+   error[0] = '\0';
+   pwbuf = (DBXWBUF *) pcon->p_wbuf;
+
+   if (limit[0] > 0) {
+      if (!pwbuf) {
+         pwbuf = (DBXWBUF *) mg_malloc(sizeof(DBXWBUF), 0);
+         if (pwbuf) {
+            memset((void *) pwbuf, 0, sizeof(DBXWBUF));
+            pcon->p_wbuf = (void *) pwbuf;
+         }
+         else {
+            rc = CACHE_FAILURE;
+         }
+      }
+      if (pwbuf) {
+         pwbuf->max_entries = limit[0];
+         pwbuf->max_size = (limit[1] > 0) ? (unsigned long) limit[1] : DBX_WBUF_MAXSIZE;
+         pwbuf->max_age = (limit[2] > 0) ? limit[2] : 0;
+         if (pwbuf->entries >= pwbuf->max_entries || pwbuf->size >= pwbuf->max_size) {
+            mg_wbuf_flush(pcon);
+         }
+      }
+   }
+   else if (pwbuf) { /* disable buffering */
+      mg_wbuf_flush(pcon);
+      strcpy(error, pwbuf->error);
+      pcon->p_wbuf = NULL;
+      mg_free((void *) pwbuf, 0);
+   }
+
+   if (rc != CACHE_SUCCESS) {
+      mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, "Unable to allocate memory for the write buffer");
+   }
+   else if (error[0]) {
+      mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, error);
+   }
+   else {
+      mg_create_string(pmeth, (void *) &rc, DBX_DTYPE_INT);
+   }
+
+   DBX_UNLOCK(rc);
+
+   return 0;
+}
+
+
+DBX_EXTFUN(int) dbx_flush(unsigned char *input, unsigned char *output)
+{
+   int rc, n, due;
+   unsigned long long age;
+   DBXMETH *pmeth;
+   DBXCON *pcon;
+   DBXWBUF *pwbuf;
+
+   DBX_SESSION_CALL(dbx_flush, input, output);
+
+   pmeth = mg_unpack_header(input, output);
+   pcon = pmeth->pcon;
+
+   if (!pcon || !pcon->connected) {
+      mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, "No Database Connection");
+      return 1;
+   }
+
+   mg_unpack_arguments(pmeth);
+
+   /* v1.3.22: argument "1" - write the buffered Sets only if the oldest has been held for the maximum age set by dbx_buffer() */
+   due = (pmeth->argc > 0 && pmeth->args[0].svalue.len_used == 1 && pmeth->args[0].svalue.buf_addr[0] == '1');
+
+   DBX_LOCK(rc, 0);
+
+   if (due) { /* return the time (ms) until the buffered Sets are due to be written, or -1 if none are held */
+      n = -1;
+      pwbuf = (DBXWBUF *) pcon->p_wbuf;
+      if (pwbuf && pwbuf->entries && pwbuf->max_age > 0) {
+         age = mg_time_ms() - pwbuf->first;
+         if (age >= (unsigned long long) pwbuf->max_age) {
+            mg_wbuf_flush(pcon); /* a failure is reported by the next Set or Flush */
+         }
+         else {
+            n = (int) (pwbuf->max_age - (int) age);
+         }
+      }
+      mg_create_string(pmeth, (void *) &n, DBX_DTYPE_INT);
+      DBX_UNLOCK(rc);
+      return 0;
+   }
+
+   n = 0;
+   pwbuf = (DBXWBUF *) pcon->p_wbuf;
+   if (pwbuf) {
+      n = pwbuf->entries;
+      mg_wbuf_flush(pcon);
+   }
+
+   if (pwbuf && pwbuf->error[0]) {
+      mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, pwbuf->error);
+      pwbuf->error[0] = '\0';
+   }
+   else {
+      mg_create_string(pmeth, (void *) &n, DBX_DTYPE_INT); /* number of nodes written */
+   }
+
+   DBX_UNLOCK(rc);
+
+   return 0;
+}
+
+
+/* v1.3.22: keep 'n' connected standby sockets ready to replace the network connection */
+DBX_EXTFUN(int) dbx_standby(unsigned char *input, unsigned char *output)
+{
+   int rc, size;
+   char buffer[32];
+   DBXMETH *pmeth;
+   DBXCON *pcon;
+   DBXSTBY *pstby;
+
+   DBX_SESSION_CALL(dbx_standby, input, output);
+
+   pmeth = mg_unpack_header(input, output);
+   pcon = pmeth->pcon;
+
+   if (!pcon || !pcon->connected) {
+      mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, "No Database Connection");
+      return 1;
+   }
+
+   mg_unpack_arguments(pmeth);
+
+   /* Argument: number of standby connections */
+   size = 0;
+   if (pmeth->argc > 0 && pmeth->args[0].svalue.len_used < 32) {
+      strncpy(buffer, pmeth->args[0].svalue.buf_addr, pmeth->args[0].svalue.len_used);
+      buffer[pmeth->args[0].svalue.len_used] = '\0';
+      size = (int) strtol(buffer, NULL, 10);
+   }
+   if (size > DBX_STBY_MAX) {
+      size = DBX_STBY_MAX;
+   }
+
+   if (pcon->connected != 2 || pcon->p_srv) {
+      mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, "Standby connections are only available for network based connectivity");
+      return 1;
+   }
+
+   DBX_LOCK(rc, 0);
+
+   rc = CACHE_SUCCESS;
+
+   mg_enter_critical_section((void *) &dbx_global_mutex);
+   pstby = (DBXSTBY *) pcon->p_stby;
+   if (size > 0) {
+      if (!pstby) {
+         pstby = (DBXSTBY *) mg_malloc(sizeof(DBXSTBY), 0);
+         if (pstby) {
+            memset((void *) pstby, 0, sizeof(DBXSTBY));
+            pstby->dbtype = pcon->dbtype;
+            pstby->port = pcon->port;
+            pstby->timeout = pcon->timeout;
+            strcpy(pstby->ip_address, pcon->ip_address);
+            strcpy(pstby->nspace, pcon->nspace);
+            pstby->pnext = dbx_stby_list;
+            dbx_stby_list = pstby;
+            pcon->p_stby = (void *) pstby;
+         }
+         else {
+            rc = CACHE_FAILURE;
+         }
+      }
+      if (pstby) {
+         pstby->size = size;
+         rc = netx_stby_start();
+      }
+   }
+   else if (pstby) {
+      pstby->closed = 1;
+      pcon->p_stby = NULL;
+   }
+   mg_leave_critical_section((void *) &dbx_global_mutex);
+
+   if (rc != CACHE_SUCCESS) {
+      mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, "Unable to start the standby connections");
+   }
+   else {
+      mg_create_string(pmeth, (void *) &size, DBX_DTYPE_INT);
+   }
+
+   DBX_UNLOCK(rc);
+
+   return 0;
+}
+
+
+int isc_load_library(DBXCON *pcon)
 {
    int n, len, result;
    char primlib[DBX_ERROR_SIZE], primerr[DBX_ERROR_SIZE];
@@ -3343,6 +5161,7 @@ isc_authenticate_reopen:
       goto isc_authenticate_reopen;
    }
 
+   pcon->cur_nspace[0] = '\0'; /* v1.3.22 */
    rc = isc_change_namespace(pcon, pcon->nspace);
 
    if (pcon->p_isc_so && pcon->p_isc_so->p_CacheEnableMultiThread) {
@@ -3356,55 +5175,355 @@ isc_authenticate_reopen:
 }
 
 
-int isc_open(DBXMETH *pmeth)
-{
-   int rc, error_code, result;
-   DBXCON *pcon = pmeth->pcon;
+/*
+   v1.3.22: Callin sessions are bound to the thread that starts them.  For a 'threaded' connection
+   the session is started in a thread created for the purpose, and every subsequent request for the
+   connection is passed to that thread (DBX_SESSION_CALL) which runs it and returns the result.
+   Each connection has its own session so several connections can be used concurrently.
+*/
 
-   error_code = 0;
-   rc = CACHE_SUCCESS;
+int isc_session_start(DBXCON *pcon)
+{
+   int rc;
+   DBXSESS *psess;
+#if !defined(_WIN32)
+   pthread_attr_t attr;
+#endif
 
-   if (!pcon->p_isc_so) {
-      pcon->p_isc_so = (DBXISCSO *) mg_malloc(sizeof(DBXISCSO), 0);
-      if (!pcon->p_isc_so) {
-         strcpy(pcon->error, "No Memory");
-         pcon->error_code = 1009; 
-         result = CACHE_NOCON;
-         return result;
-      }
-      memset((void *) pcon->p_isc_so, 0, sizeof(DBXISCSO));
-      pcon->p_isc_so->loaded = 0;
+   psess = (DBXSESS *) mg_malloc(sizeof(DBXSESS), 0);
+   if (!psess) {
+      strcpy(pcon->error, "No Memory");
+      pcon->error_code = 1009;
+      return CACHE_NOCON;
    }
+   memset((void *) psess, 0, sizeof(DBXSESS));
+   psess->pcon = pcon;
 
-   if (pcon->p_isc_so->loaded == 2) {
-      strcpy(pcon->error, "Cannot create multiple connections to the database");
-      pcon->error_code = 1009; 
+#if defined(_WIN32)
+   InitializeCriticalSection(&(psess->call_mutex));
+   psess->req_event = CreateEvent(NULL, FALSE, FALSE, NULL); /* auto-reset */
+   psess->res_event = CreateEvent(NULL, FALSE, FALSE, NULL);
+   if (psess->req_event && psess->res_event) {
+      psess->hthread = CreateThread(NULL, DBX_THREAD_STACK_SIZE, isc_session_thread, (LPVOID) psess, 0, &(psess->tid));
+   }
+   if (!psess->hthread) {
+      sprintf(pcon->error, "Unable to create the session thread (%lu)", (unsigned long) GetLastError());
+      pcon->error_code = 1009;
       rc = CACHE_NOCON;
-      goto isc_open_exit;
+      goto isc_session_start_exit;
    }
 
-   if (!pcon->p_isc_so->loaded) {
-      pcon->p_isc_so->merge_enabled = 0;
+   /* wait for the outcome of the authentication */
+   WaitForSingleObject(psess->res_event, INFINITE);
+   rc = psess->rc;
+
+   if (rc == CACHE_SUCCESS) {
+      pcon->p_sess = (void *) psess;
+      return rc;
    }
 
-   if (!pcon->p_isc_so->loaded) {
-      rc = isc_load_library(pcon);
+   WaitForSingleObject(psess->hthread, INFINITE);
+   CloseHandle(psess->hthread);
 
-      sprintf((char *) pmeth->output_val.svalue.buf_addr, "%d", rc);
-      pmeth->output_val.svalue.len_used = (unsigned int) strlen((char *) pmeth->output_val.svalue.buf_addr);
-      if (rc != CACHE_SUCCESS) {
-         goto isc_open_exit;
-      }
-   }
+isc_session_start_exit:
 
-   rc = pcon->p_isc_so->p_CacheSetDir(pcon->shdir);
+   if (psess->res_event) {
+      CloseHandle(psess->res_event);
+   }
+   if (psess->req_event) {
+      CloseHandle(psess->req_event);
+   }
+   DeleteCriticalSection(&(psess->call_mutex));
+   mg_free((void *) psess, 0);
 
-   if (!isc_authenticate(pcon)) {
+   return rc;
+#else
+   pthread_mutex_init(&(psess->call_mutex), NULL);
+   pthread_mutex_init(&(psess->cv_mutex), NULL);
+   pthread_cond_init(&(psess->req_cv), NULL);
+   pthread_cond_init(&(psess->res_cv), NULL);
+
+   pthread_attr_init(&attr);
+   pthread_attr_setstacksize(&attr, DBX_THREAD_STACK_SIZE);
+
+   rc = pthread_create(&(psess->tid), &attr, isc_session_thread, (void *) psess);
+   pthread_attr_destroy(&attr);
+   if (rc) {
+      sprintf(pcon->error, "Unable to create the session thread (%d)", rc);
+      pcon->error_code = 1009;
+      rc = CACHE_NOCON;
+      goto isc_session_start_exit;
+   }
+
+   /* wait for the outcome of the authentication */
+   pthread_mutex_lock(&(psess->cv_mutex));
+   while (!psess->done) {
+      pthread_cond_wait(&(psess->res_cv), &(psess->cv_mutex));
+   }
+   rc = psess->rc;
+   pthread_mutex_unlock(&(psess->cv_mutex));
+
+   if (rc == CACHE_SUCCESS) {
+      pcon->p_sess = (void *) psess;
+      return rc;
+   }
+
+   pthread_join(psess->tid, NULL);
+
+isc_session_start_exit:
+
+   pthread_cond_destroy(&(psess->res_cv));
+   pthread_cond_destroy(&(psess->req_cv));
+   pthread_mutex_destroy(&(psess->cv_mutex));
+   pthread_mutex_destroy(&(psess->call_mutex));
+   mg_free((void *) psess, 0);
+
+   return rc;
+#endif
+}
+
+
+#if defined(_WIN32)
+DWORD WINAPI isc_session_thread(LPVOID pargs)
+#else
+void * isc_session_thread(void *pargs)
+#endif
+{
+   int rc;
+   DBXSESS *psess;
+
+   psess = (DBXSESS *) pargs;
+
+   rc = isc_authenticate(psess->pcon) ? CACHE_SUCCESS : CACHE_NOCON;
+
+#if defined(_WIN32)
+   /* the events order the exchange: each caller waits for the result before the next request is posted */
+   psess->rc = rc;
+   psess->done = 1;
+   if (rc != CACHE_SUCCESS) {
+      psess->end = 1;
+   }
+   SetEvent(psess->res_event);
+
+   while (!psess->end) {
+      WaitForSingleObject(psess->req_event, INFINITE);
+      psess->request = 0;
+
+      rc = psess->p_fun(psess->input, psess->output);
+
+      psess->rc = rc;
+      psess->done = 1;
+      SetEvent(psess->res_event);
+   }
+
+   return 0;
+#else
+   pthread_mutex_lock(&(psess->cv_mutex));
+   psess->rc = rc;
+   psess->done = 1;
+   if (rc != CACHE_SUCCESS) {
+      psess->end = 1;
+   }
+   pthread_cond_signal(&(psess->res_cv));
+
+   while (!psess->end) {
+      while (!psess->request) {
+         pthread_cond_wait(&(psess->req_cv), &(psess->cv_mutex));
+      }
+      psess->request = 0;
+      pthread_mutex_unlock(&(psess->cv_mutex));
+
+      rc = psess->p_fun(psess->input, psess->output);
+
+      pthread_mutex_lock(&(psess->cv_mutex));
+      psess->rc = rc;
+      psess->done = 1;
+      pthread_cond_signal(&(psess->res_cv));
+   }
+   pthread_mutex_unlock(&(psess->cv_mutex));
+
+   return NULL;
+#endif
+}
+
+
+/* return the session thread that should run a request, or NULL if the request can be run in this thread */
+DBXSESS * isc_session(unsigned char *input)
+{
+   int index;
+   DBXCON *pcon;
+   DBXSESS *psess;
+
+   if (!input) {
+      return NULL;
+   }
+   index = (int) mg_get_size(input + 10);
+   if (index < 0 || index >= DBX_MAXCONS) {
+      return NULL;
+   }
+   pcon = connection[index];
+   if (!pcon || !pcon->p_sess) {
+      return NULL;
+   }
+   psess = (DBXSESS *) pcon->p_sess;
+#if defined(_WIN32)
+   if (GetCurrentThreadId() == psess->tid) {
+      return NULL;
+   }
+#else
+   if (pthread_equal(pthread_self(), psess->tid)) {
+      return NULL;
+   }
+#endif
+
+   return psess;
+}
+
+
+int isc_session_call(int (* p_fun) (unsigned char *input, unsigned char *output), unsigned char *input, unsigned char *output)
+{
+   int rc, last;
+   DBXSESS *psess;
+
+   /* count the callers using the session, so that it is freed by the last of them once the connection is closed */
+   mg_enter_critical_section((void *) &dbx_global_mutex);
+   psess = isc_session(input);
+   if (psess) {
+      psess->users ++;
+   }
+   mg_leave_critical_section((void *) &dbx_global_mutex);
+
+   if (!psess) {
+      return p_fun(input, output);
+   }
+
+   /* one request at a time for each session */
+#if defined(_WIN32)
+   EnterCriticalSection(&(psess->call_mutex));
+
+   if (psess->end) { /* the connection was closed while this call waited its turn */
+      LeaveCriticalSection(&(psess->call_mutex));
+      mg_set_error_message_ex(output ? output : input, "No Database Connection");
+      rc = 1;
+      goto isc_session_call_exit;
+   }
+   psess->p_fun = p_fun;
+   psess->input = input;
+   psess->output = output;
+   psess->done = 0;
+   psess->request = 1;
+   SetEvent(psess->req_event);
+   WaitForSingleObject(psess->res_event, INFINITE);
+   rc = psess->rc;
+
+   LeaveCriticalSection(&(psess->call_mutex));
+#else
+   pthread_mutex_lock(&(psess->call_mutex));
+
+   pthread_mutex_lock(&(psess->cv_mutex));
+   if (psess->end) { /* the connection was closed while this call waited its turn */
+      pthread_mutex_unlock(&(psess->cv_mutex));
+      pthread_mutex_unlock(&(psess->call_mutex));
+      mg_set_error_message_ex(output ? output : input, "No Database Connection");
+      rc = 1;
+      goto isc_session_call_exit;
+   }
+   psess->p_fun = p_fun;
+   psess->input = input;
+   psess->output = output;
+   psess->done = 0;
+   psess->request = 1;
+   pthread_cond_signal(&(psess->req_cv));
+   while (!psess->done) {
+      pthread_cond_wait(&(psess->res_cv), &(psess->cv_mutex));
+   }
+   rc = psess->rc;
+   pthread_mutex_unlock(&(psess->cv_mutex));
+
+   pthread_mutex_unlock(&(psess->call_mutex));
+#endif
+
+isc_session_call_exit:
+
+   mg_enter_critical_section((void *) &dbx_global_mutex);
+   psess->users --;
+   last = (psess->end && psess->users == 0);
+   mg_leave_critical_section((void *) &dbx_global_mutex);
+
+   if (last) { /* the connection has been closed and no other call is waiting on the session */
+#if defined(_WIN32)
+      WaitForSingleObject(psess->hthread, INFINITE);
+      CloseHandle(psess->hthread);
+      CloseHandle(psess->res_event);
+      CloseHandle(psess->req_event);
+      DeleteCriticalSection(&(psess->call_mutex));
+#else
+      pthread_join(psess->tid, NULL);
+      pthread_cond_destroy(&(psess->res_cv));
+      pthread_cond_destroy(&(psess->req_cv));
+      pthread_mutex_destroy(&(psess->cv_mutex));
+      pthread_mutex_destroy(&(psess->call_mutex));
+#endif
+      mg_free((void *) psess, 0);
+   }
+
+   return rc;
+}
+
+
+int isc_open(DBXMETH *pmeth)
+{
+   int rc, error_code, result;
+   DBXCON *pcon = pmeth->pcon;
+
+   error_code = 0;
+   rc = CACHE_SUCCESS;
+
+   if (!pcon->p_isc_so) { /* v1.3.22: use the library already loaded by another connection */
+      pcon->p_isc_so = (DBXISCSO *) mg_library_get(pcon);
+      if (pcon->p_isc_so) {
+         pcon->pid = mg_current_process_id();
+      }
+   }
+
+   if (!pcon->p_isc_so) {
+      pcon->p_isc_so = (DBXISCSO *) mg_malloc(sizeof(DBXISCSO), 0);
+      if (!pcon->p_isc_so) {
+         strcpy(pcon->error, "No Memory");
+         pcon->error_code = 1009; 
+         result = CACHE_NOCON;
+         return result;
+      }
+      memset((void *) pcon->p_isc_so, 0, sizeof(DBXISCSO));
+      pcon->p_isc_so->loaded = 0;
+   }
+
+   if (!pcon->p_isc_so->loaded) {
+      pcon->p_isc_so->merge_enabled = 0;
+   }
+
+   if (!pcon->p_isc_so->loaded) {
+      rc = isc_load_library(pcon);
+
+      sprintf((char *) pmeth->output_val.svalue.buf_addr, "%d", rc);
+      pmeth->output_val.svalue.len_used = (unsigned int) strlen((char *) pmeth->output_val.svalue.buf_addr);
+      if (rc != CACHE_SUCCESS) {
+         goto isc_open_exit;
+      }
+      mg_library_add(pcon, (void *) pcon->p_isc_so);
+   }
+
+   rc = pcon->p_isc_so->p_CacheSetDir(pcon->shdir);
+
+   /* v1.3.22: the library may be shared, so 'loaded' is no longer advanced to 2 to mark a connected session */
+   if (pcon->threaded) { /* v1.3.22: the session is started, and used, in a thread of its own */
+      rc = isc_session_start(pcon);
+   }
+   else if (!isc_authenticate(pcon)) {
       pcon->error_code = error_code;
       rc = CACHE_NOCON;
    }
    else {
-      pcon->p_isc_so->loaded = 2;
       rc = CACHE_SUCCESS;
    }
 
@@ -3476,6 +5595,7 @@ int isc_parse_zv(char *zv, DBXZV * p_isc_sv)
 int isc_change_namespace(DBXCON *pcon, char *nspace)
 {
    int rc, len;
+   char unspace[72];
    CACHE_ASTR expr;
 
    len = (int) strlen(nspace);
@@ -3486,6 +5606,13 @@ int isc_change_namespace(DBXCON *pcon, char *nspace)
       return CACHE_ERNAMSP;
    }
 
+   /* v1.3.22: namespace names are not case sensitive and $Namespace returns them in upper case */
+   strcpy(unspace, nspace);
+   mg_ucase(unspace);
+   if (!strcmp(unspace, pcon->cur_nspace)) {
+      return CACHE_SUCCESS;
+   }
+
    sprintf((char *) expr.str, "ZN \"%s\"", nspace); /* changes namespace */
    expr.len = (unsigned short) strlen((char *) expr.str);
 
@@ -3495,10 +5622,81 @@ int isc_change_namespace(DBXCON *pcon, char *nspace)
 
    mg_mutex_unlock(pcon->p_db_mutex);
 
+   mg_namespace_set(pcon, (rc == CACHE_SUCCESS) ? unspace : NULL);
+
+   mg_function_cache_clear(pcon, 0); /* v1.3.22 */
+
    return rc;
 }
 
 
+/* v1.3.22: write the command that locks a list of nodes in one step: L +(^g1(s1,...),^g2(...),...):timeout
+   Returns 0 if the list cannot be written as a command (an unusual global name, a subscript containing
+   control characters, or a command too long), in which case the nodes are locked one at a time
+*/
+int isc_lock_command(DBXMETH *pmeth, int *nodes, int *nsubs, int nnodes, int timeout, CACHE_ASTR *cmd)
+{
+   int n, s, i, len, max;
+   unsigned char c, *p;
+   char *pcmd;
+   DBXSTR *pval;
+
+   pcmd = (char *) cmd->str;
+   max = (CACHE_MAXSTRLEN - 32); /* room for the closing characters and the timeout */
+   strcpy(pcmd, "L +(");
+   len = 4;
+
+   for (n = 0; n < nnodes; n ++) {
+      if (n > 0) {
+         pcmd[len ++] = ',';
+      }
+      for (s = 0; s <= nsubs[n]; s ++) {
+         pval = &(pmeth->args[nodes[n] + s].svalue);
+         p = (unsigned char *) pval->buf_addr;
+         if (s > 0) {
+            pcmd[len ++] = (s == 1) ? '(' : ',';
+            pcmd[len ++] = '"';
+         }
+         for (i = 0; i < (int) pval->len_used; i ++) {
+            c = p[i];
+            if (len >= max) {
+               return 0;
+            }
+            if (s == 0) { /* the global name */
+               if (!(isalnum((int) c) || c == '^' || c == '%' || c == '.')) {
+                  return 0;
+               }
+            }
+            else if (c < 32 || c == 127) {
+               return 0;
+            }
+            else if (c == '"') {
+               pcmd[len ++] = '"';
+            }
+            pcmd[len ++] = (char) c;
+         }
+         if (s > 0) {
+            pcmd[len ++] = '"';
+         }
+      }
+      if (nsubs[n] > 0) {
+         pcmd[len ++] = ')';
+      }
+      if (len >= max) {
+         return 0;
+      }
+   }
+   pcmd[len ++] = ')';
+   pcmd[len] = '\0';
+   if (timeout >= 0) {
+      len += sprintf(pcmd + len, ":%d", timeout);
+   }
+   cmd->len = (unsigned short) len;
+
+   return 1;
+}
+
+
 int isc_pop_value(DBXCON *pcon, DBXVAL *value, int required_type)
 {
    int rc, ex, ctype, offset, oref;
@@ -3518,6 +5716,9 @@ int isc_pop_value(DBXCON *pcon, DBXVAL *value, int required_type)
 
       if (ctype == CACHE_OREF) {
          rc = pcon->p_isc_so->p_CachePopOref((unsigned int *) &oref);
+         if (rc == CACHE_SUCCESS && mg_oref_add(pcon, oref) > 1) { /* v1.3.22: one server reference is kept for each OREF */
+            pcon->p_isc_so->p_CacheCloseOref(oref);
+         }
 
          value->type = DBX_DTYPE_OREF;
          value->num.oref = oref;
@@ -3591,6 +5792,230 @@ int isc_pop_value(DBXCON *pcon, DBXVAL *value, int required_type)
 }
 
 
+/* v1.3.22: push an argument as a string, using a long string where necessary */
+int isc_push_value(DBXCON *pcon, DBXVAL *value)
+{
+   int rc;
+   unsigned int n;
+
+   if (value->svalue.len_used < DBX_MAXSIZE) {
+      rc = pcon->p_isc_so->p_CachePushStr(value->svalue.len_used, (Callin_char_t *) value->svalue.buf_addr);
+   }
+   else {
+      value->cvalue.pstr = (void *) pcon->p_isc_so->p_CacheExStrNew((CACHE_EXSTRP) &(value->cvalue.zstr), value->svalue.len_used + 1);
+      if (value->cvalue.pstr == NULL) {
+         return CACHE_FAILURE;
+      }
+      for (n = 0; n < value->svalue.len_used; n ++) {
+         value->cvalue.zstr.str.ch[n] = (char) value->svalue.buf_addr[n];
+      }
+      value->cvalue.zstr.str.ch[n] = (char) 0;
+      value->cvalue.zstr.len = value->svalue.len_used;
+
+      rc = pcon->p_isc_so->p_CachePushExStr((CACHE_EXSTRP) &(value->cvalue.zstr));
+   }
+
+   return rc;
+}
+
+
+/* v1.3.18 */
+int isc_push_node(DBXCON *pcon, DBXSTR *global, char *buffer, int nkeys, int *kpos, int *klen)
+{
+   int rc, n;
+
+   if (global->buf_addr[0] == '^')
+      rc = pcon->p_isc_so->p_CachePushGlobal((int) global->len_used - 1, (Callin_char_t *) global->buf_addr + 1);
+   else
+      rc = pcon->p_isc_so->p_CachePushGlobal((int) global->len_used, (Callin_char_t *) global->buf_addr);
+
+   for (n = 0; n < nkeys && rc == CACHE_SUCCESS; n ++) {
+      rc = pcon->p_isc_so->p_CachePushStr(klen[n], (Callin_char_t *) buffer + kpos[n]);
+   }
+
+   return rc;
+}
+
+
+/* v1.3.18: Decode the next item in a $List (as returned by $query) to its string form */
+int isc_list_item(unsigned char *list, int list_len, int *offset, char *buffer, int buffer_size)
+{
+   int n, len, hlen, type, dlen, exp;
+   unsigned int c;
+   long long mant;
+   unsigned char *p;
+   char number[512];
+   union {
+      double real;
+      unsigned char b[8];
+   } ieee;
+
+   p = list + *offset;
+   len = (int) p[0];
+   hlen = 2;
+   if (len == 0) {
+      len = (int) (p[1] | (p[2] << 8));
+      hlen = 4;
+      if (len == 0) {
+         len = (int) (p[3] | (p[4] << 8) | (p[5] << 16) | (p[6] << 24));
+         hlen = 8;
+      }
+      len += (hlen - 1);
+   }
+   if (len < hlen || (*offset + len) > list_len) {
+      return -1;
+   }
+   type = (int) p[hlen - 1];
+   dlen = len - hlen;
+   p += hlen;
+   *offset += len;
+
+   switch (type) {
+      case 2: /* 16-bit characters (UTF-16LE): returned as UTF-8 */
+         dlen /= 2;
+         len = 0;
+         for (n = 0; n < dlen; n ++) {
+            c = (unsigned int) (p[n * 2] | (p[(n * 2) + 1] << 8));
+            if (c >= 0xd800 && c < 0xdc00 && (n + 1) < dlen) {
+               hlen = (int) (p[(n * 2) + 2] | (p[(n * 2) + 3] << 8));
+               if (hlen >= 0xdc00 && hlen < 0xe000) {
+                  c = 0x10000 + ((c - 0xd800) << 10) + (unsigned int) (hlen - 0xdc00);
+                  n ++;
+               }
+            }
+            if ((len + 4) > buffer_size) {
+               return -1;
+            }
+            if (c < 0x80) {
+               buffer[len ++] = (char) c;
+            }
+            else if (c < 0x800) {
+               buffer[len ++] = (char) (0xc0 | (c >> 6));
+               buffer[len ++] = (char) (0x80 | (c & 0x3f));
+            }
+            else if (c < 0x10000) {
+               buffer[len ++] = (char) (0xe0 | (c >> 12));
+               buffer[len ++] = (char) (0x80 | ((c >> 6) & 0x3f));
+               buffer[len ++] = (char) (0x80 | (c & 0x3f));
+            }
+            else {
+               buffer[len ++] = (char) (0xf0 | (c >> 18));
+               buffer[len ++] = (char) (0x80 | ((c >> 12) & 0x3f));
+               buffer[len ++] = (char) (0x80 | ((c >> 6) & 0x3f));
+               buffer[len ++] = (char) (0x80 | (c & 0x3f));
+            }
+         }
+         return len;
+      case 4: /* positive integer */
+      case 5: /* negative integer */
+      case 6: /* positive decimal */
+      case 7: /* negative decimal */
+         mant = 0;
+         n = (type == 6 || type == 7) ? 1 : 0;
+         for (len = dlen - 1; len >= n; len --) {
+            mant = (mant << 8) | p[len];
+         }
+         if ((type == 5 || type == 7) && (dlen - n) < 8) {
+            mant -= ((long long) 1 << (8 * (dlen - n)));
+         }
+         len = isc_list_number(number, mant, n ? (int) ((signed char) p[0]) : 0);
+         break;
+      case 8: /* IEEE double */
+         for (n = 0; n < 8; n ++) {
+            ieee.b[n] = (n < dlen) ? p[n] : 0;
+         }
+         /* canonic form from the 15 significant digits held: mant * (10 ** (exp - 14)) */
+         sprintf(number, "%.14e", ieee.real);
+         n = (number[0] == '-') ? 1 : 0;
+         if (number[n] < '0' || number[n] > '9') { /* inf or nan */
+            len = (int) strlen(number);
+            break;
+         }
+         mant = 0;
+         for (n = 0; number[n] && number[n] != 'e'; n ++) {
+            if (number[n] >= '0' && number[n] <= '9') {
+               mant = (mant * 10) + (number[n] - '0');
+            }
+         }
+         exp = number[n] ? (int) strtol(number + n + 1, NULL, 10) : 0;
+         if (number[0] == '-') {
+            mant = -mant;
+         }
+         len = isc_list_number(number, mant, exp - 14);
+         break;
+      default: /* 8-bit characters */
+         if (dlen > buffer_size) {
+            return -1;
+         }
+         memcpy((void *) buffer, (void *) p, (size_t) dlen);
+         return dlen;
+   }
+
+   if (len > buffer_size) {
+      return -1;
+   }
+   memcpy((void *) buffer, (void *) number, (size_t) len);
+
+   return len;
+}
+
+
+/* v1.3.18: Produce the canonic form of mant * (10 ** exp) */
+int isc_list_number(char *buffer, long long mant, int exp)
+{
+   int n, len, pos;
+   char digits[32];
+
+   if (mant == 0) {
+      strcpy(buffer, "0");
+      return 1;
+   }
+
+   n = 0;
+   if (mant < 0) {
+      buffer[n ++] = '-';
+      mant = -mant;
+   }
+   sprintf(digits, "%lld", mant);
+   len = (int) strlen(digits);
+
+   if (exp >= 0) {
+      memcpy((void *) (buffer + n), (void *) digits, (size_t) len);
+      n += len;
+      while (exp -- > 0) {
+         buffer[n ++] = '0';
+      }
+   }
+   else {
+      pos = len + exp;
+      if (pos > 0) {
+         memcpy((void *) (buffer + n), (void *) digits, (size_t) pos);
+         n += pos;
+         buffer[n ++] = '.';
+         memcpy((void *) (buffer + n), (void *) (digits + pos), (size_t) (len - pos));
+         n += (len - pos);
+      }
+      else {
+         buffer[n ++] = '.';
+         while (pos ++ < 0) {
+            buffer[n ++] = '0';
+         }
+         memcpy((void *) (buffer + n), (void *) digits, (size_t) len);
+         n += len;
+      }
+      while (buffer[n - 1] == '0') {
+         n --;
+      }
+      if (buffer[n - 1] == '.') {
+         n --;
+      }
+   }
+   buffer[n] = '\0';
+
+   return n;
+}
+
+
 int isc_error_message(DBXMETH *pmeth, int error_code)
 {
    int size, size1, len;
@@ -3618,7 +6043,7 @@ int isc_error_message(DBXMETH *pmeth, int error_code)
    size1 = size;
 
    if (pcon->p_isc_so && pcon->p_isc_so->p_CacheErrxlateA) {
-      pcerror = (CACHE_ASTR *) mg_malloc(sizeof(CACHE_ASTR), 801);
+      pcerror = (CACHE_ASTR *) mg_arena_alloc(pcon, sizeof(CACHE_ASTR)); /* v1.3.22 */
       if (pcerror) {
          pcerror->str[0] = '\0';
          pcerror->len = 50;
@@ -3635,7 +6060,6 @@ int isc_error_message(DBXMETH *pmeth, int error_code)
             strncpy(pcon->error, (char *) pcerror->str, len);
             pcon->error[len] = '\0';
          }
-         mg_free((void *) pcerror, 801);
          size1 -= (int) strlen(pcon->error);
          if (len) { /* v1.3.12 */
             goto isc_error_message_exit;
@@ -3962,12 +6386,18 @@ int ydb_load_library(DBXCON *pcon)
       goto ydb_load_library_exit;
    }
 
+   sprintf(fun, "%s_lock_s", pcon->p_ydb_so->funprfx); /* v1.3.22: optional */
+   pcon->p_ydb_so->p_ydb_lock_s = (int (*) (unsigned long long, int, ...)) mg_dso_sym(pcon->p_ydb_so->p_library, (char *) fun);
+
    sprintf(fun, "%s_zstatus", pcon->p_ydb_so->funprfx);
    pcon->p_ydb_so->p_ydb_zstatus = (void (*) (ydb_char_t *, ydb_long_t)) mg_dso_sym(pcon->p_ydb_so->p_library, (char *) fun);
 
    sprintf(fun, "%s_tp_s", pcon->p_ydb_so->funprfx);
    pcon->p_ydb_so->p_ydb_tp_s = (int (*) (ydb_tpfnptr_t, void *, const char *, int, ydb_buffer_t *)) mg_dso_sym(pcon->p_ydb_so->p_library, (char *) fun);
 
+   if (ydb_load_library_st(pcon) != CACHE_SUCCESS) { /* v1.3.22 */
+      goto ydb_load_library_exit;
+   }
 
    pcon->pid = mg_current_process_id();
 
@@ -3995,7 +6425,14 @@ int ydb_open(DBXMETH *pmeth)
 
    rc = CACHE_SUCCESS;
 
-   if (!pcon->p_ydb_so) {
+   if (!pcon->p_ydb_so) { /* v1.3.22: use the library already loaded by another connection */
+      pcon->p_ydb_so = (DBXYDBSO *) mg_library_get(pcon);
+      if (pcon->p_ydb_so) {
+         pcon->pid = mg_current_process_id();
+      }
+   }
+
+   if (!pcon->p_ydb_so) {
       pcon->p_ydb_so = (DBXYDBSO *) mg_malloc(sizeof(DBXYDBSO), 0);
       if (!pcon->p_ydb_so) {
          strcpy(pcon->error, "No Memory");
@@ -4007,14 +6444,6 @@ int ydb_open(DBXMETH *pmeth)
       pcon->p_ydb_so->loaded = 0;
    }
 
-   if (pcon->p_ydb_so->loaded == 2) {
-      strcpy(pcon->error, "Cannot create multiple connections to the database");
-      pcon->error_code = 1009; 
-      strcpy((char *) pmeth->output_val.svalue.buf_addr, "0");
-      rc = CACHE_NOCON;
-      goto ydb_open_exit;
-   }
-
    if (!pcon->p_ydb_so->loaded) {
       rc = ydb_load_library(pcon);
       sprintf((char *) pmeth->output_val.svalue.buf_addr, "%d", rc);
@@ -4022,6 +6451,18 @@ int ydb_open(DBXMETH *pmeth)
       if (rc != CACHE_SUCCESS) {
          goto ydb_open_exit;
       }
+      mg_library_add(pcon, (void *) pcon->p_ydb_so);
+   }
+
+   if (pcon->threaded != pcon->p_ydb_so->threaded) { /* v1.3.22: the first connection selects the API for the process */
+      sprintf(pcon->error, "Error loading %s library: %s; The %s has been selected by the first connection in the process", pcon->p_ydb_so->dbname, pcon->p_ydb_so->libnam, pcon->p_ydb_so->threaded ? "SimpleThreadAPI" : "SimpleAPI");
+      pcon->error_code = 1009;
+      mg_library_release(pcon);
+      rc = CACHE_NOCON;
+      goto ydb_open_exit;
+   }
+   if (pcon->p_ydb_so->threaded) { /* v1.3.22: the connection may be used from different threads (one request at a time) */
+      pcon->use_db_mutex = 1;
    }
 
    rc = pcon->p_ydb_so->p_ydb_init();
@@ -4136,7 +6577,11 @@ int ydb_error_message(DBXMETH *pmeth, int error_code)
    DBXCON *pcon = pmeth->pcon;
 
    rc = CACHE_SUCCESS;
-   if (pcon->p_ydb_so && pcon->p_ydb_so->p_ydb_get_s) {
+   if (pcon->p_ydb_so && pcon->p_ydb_so->threaded && dbx_ydb_errbuf[0]) { /* v1.3.22: the error returned to this thread by the SimpleThreadAPI */
+      strncpy(pcon->error, dbx_ydb_errbuf, DBX_ERROR_SIZE - 1);
+      pcon->error[DBX_ERROR_SIZE - 1] = '\0';
+   }
+   else if (pcon->p_ydb_so && pcon->p_ydb_so->p_ydb_get_s) {
       strcpy(buffer, "$zstatus");
       zstatus.buf_addr = buffer;
       zstatus.len_used = (int) strlen(buffer);
@@ -4171,28 +6616,22 @@ int ydb_error_message(DBXMETH *pmeth, int error_code)
 
 int ydb_function(DBXMETH *pmeth, DBXFUN *pfun)
 {
-   int rc;
+   int rc, n;
+   void *argv[DBX_MAXARGS];
    DBXCON *pcon = pmeth->pcon;
 
    pmeth->output_val.svalue.len_used = 0;
    pmeth->output_val.svalue.buf_addr[0] = '\0';
 
-   switch (pmeth->argc) {
-      case 1:
-         rc = pcon->p_ydb_so->p_ydb_ci(pfun->label, &(pmeth->output_val.svalue));
-         break;
-      case 2:
-         rc = pcon->p_ydb_so->p_ydb_ci(pfun->label, &(pmeth->output_val.svalue), &(pmeth->args[1].svalue));
-         break;
-      case 3:
-         rc = pcon->p_ydb_so->p_ydb_ci(pfun->label, &(pmeth->output_val.svalue), &(pmeth->args[1].svalue), &(pmeth->args[2].svalue));
-         break;
-      case 4:
-         rc = pcon->p_ydb_so->p_ydb_ci(pfun->label, &(pmeth->output_val.svalue), &(pmeth->args[1].svalue), &(pmeth->args[2].svalue), &(pmeth->args[3].svalue));
-         break;
-      default:
-         rc = CACHE_SUCCESS;
-         break;
+   if (pmeth->argc > 0 && pmeth->argc <= DBX_MAXARGS) { /* v1.3.22 */
+      argv[0] = (void *) &(pmeth->output_val.svalue);
+      for (n = 1; n < pmeth->argc; n ++) {
+         argv[n] = (void *) &(pmeth->args[n].svalue);
+      }
+      rc = ydb_ci_call(pcon, pfun->label, pfun->label_len, pmeth->argc, argv);
+   }
+   else {
+      rc = CACHE_SUCCESS;
    }
 
    pmeth->output_val.svalue.len_used = (int) strlen(pmeth->output_val.svalue.buf_addr);
@@ -4203,25 +6642,133 @@ int ydb_function(DBXMETH *pmeth, DBXFUN *pfun)
 
 int ydb_function_ex(DBXMETH *pmeth, DBXFUN *pfun)
 {
-   int rc;
+   int rc, n;
+   void *argv[DBX_MAXARGS];
    DBXCON *pcon = pmeth->pcon;
 
-   switch (pfun->argc) {
-      case 1:
-         rc = pcon->p_ydb_so->p_ydb_ci(pfun->label, &(pfun->out));
-         break;
-      case 2:
-         rc = pcon->p_ydb_so->p_ydb_ci(pfun->label, &(pfun->out), &(pfun->in[1]));
+   if (pfun->argc > 0 && pfun->argc <= DBX_MAXARGS) { /* v1.3.22 */
+      argv[0] = (void *) &(pfun->out);
+      for (n = 1; n < pfun->argc; n ++) {
+         argv[n] = (void *) &(pfun->in[n]);
+      }
+      rc = ydb_ci_call(pcon, pfun->label, pfun->label_len, pfun->argc, argv);
+   }
+   else {
+      rc = CACHE_SUCCESS;
+      pfun->out.length = 0;
+   }
+
+   return rc;
+}
+
+
+/* v1.3.22: return the cached call-in descriptor for name, adding it to the connection's table if necessary */
+ci_name_descriptor * ydb_ci_descriptor(DBXCON *pcon, char *name, int name_len)
+{
+   int n;
+   DBXCI *pci;
+   DBXCITAB *pcitab;
+
+   if (name_len < 1 || name_len >= DBX_CI_NAMELEN) {
+      return NULL;
+   }
+
+   pcitab = (DBXCITAB *) pcon->p_ci;
+   if (!pcitab) {
+      pcitab = (DBXCITAB *) mg_malloc(sizeof(DBXCITAB), 0);
+      if (!pcitab) {
+         return NULL;
+      }
+      pcitab->used = 0;
+      pcitab->next = 0;
+      pcon->p_ci = (void *) pcitab;
+   }
+
+   for (n = 0; n < pcitab->used; n ++) {
+      pci = &(pcitab->ci[n]);
+      if ((int) pci->desc.rtn_name.length == name_len && !strncmp(pci->name, name, name_len)) {
+         return &(pci->desc);
+      }
+   }
+
+   /* Not found: take the next free slot, or recycle the oldest entry once the table is full */
+   if (pcitab->used < DBX_CI_MAX) {
+      n = pcitab->used ++;
+   }
+   else {
+      n = pcitab->next;
+      pcitab->next = (pcitab->next + 1) % DBX_CI_MAX;
+   }
+   pci = &(pcitab->ci[n]);
+   strncpy(pci->name, name, name_len);
+   pci->name[name_len] = '\0';
+   pci->desc.rtn_name.address = pci->name;
+   pci->desc.rtn_name.length = (unsigned long) name_len;
+   pci->desc.handle = NULL; /* filled in by YottaDB on the first call */
+
+   return &(pci->desc);
+}
+
+
+/* v1.3.22: invoke a call-in with argc arguments through ydb_cip() */
+int ydb_ci_call(DBXCON *pcon, char *name, int name_len, int argc, void **argv)
+{
+   int rc, n, max;
+   ci_name_descriptor *pdesc, desc;
+
+   pdesc = ydb_ci_descriptor(pcon, name, name_len);
+   if (!pdesc) {
+      desc.rtn_name.address = name;
+      desc.rtn_name.length = (unsigned long) name_len;
+      desc.handle = NULL;
+      pdesc = &desc;
+   }
+
+   /* Arguments are passed in blocks, the unused tail of which is ignored by YottaDB */
+   if (argc <= 4)
+      max = 4;
+   else if (argc <= 16)
+      max = 16;
+   else if (argc <= 32)
+      max = 32;
+   else
+      max = DBX_MAXARGS;
+   for (n = argc; n < max; n ++) {
+      argv[n] = NULL;
+   }
+
+   if (pcon->p_ydb_so->threaded) { /* v1.3.22 */
+      ydb_buffer_t errstr;
+
+      switch (max) {
+         case 4:
+            rc = dbx_ydb_st.p_ydb_cip_t(dbx_ydb_tptoken, ydb_thread_errstr(&errstr), pdesc, DBX_CI_ARGS4(0));
+            break;
+         case 16:
+            rc = dbx_ydb_st.p_ydb_cip_t(dbx_ydb_tptoken, ydb_thread_errstr(&errstr), pdesc, DBX_CI_ARGS16(0));
+            break;
+         case 32:
+            rc = dbx_ydb_st.p_ydb_cip_t(dbx_ydb_tptoken, ydb_thread_errstr(&errstr), pdesc, DBX_CI_ARGS16(0), DBX_CI_ARGS16(16));
+            break;
+         default:
+            rc = dbx_ydb_st.p_ydb_cip_t(dbx_ydb_tptoken, ydb_thread_errstr(&errstr), pdesc, DBX_CI_ARGS16(0), DBX_CI_ARGS16(16), DBX_CI_ARGS16(32), DBX_CI_ARGS16(48));
+            break;
+      }
+      return ydb_thread_status(&errstr, rc);
+   }
+
+   switch (max) {
+      case 4:
+         rc = pcon->p_ydb_so->p_ydb_cip(pdesc, DBX_CI_ARGS4(0));
          break;
-      case 3:
-         rc = pcon->p_ydb_so->p_ydb_ci(pfun->label, &(pfun->out), &(pfun->in[1]), &(pfun->in[2]));
+      case 16:
+         rc = pcon->p_ydb_so->p_ydb_cip(pdesc, DBX_CI_ARGS16(0));
          break;
-      case 4:
-         rc = pcon->p_ydb_so->p_ydb_ci(pfun->label, &(pfun->out), &(pfun->in[1]), &(pfun->in[2]), &(pfun->in[3]));
+      case 32:
+         rc = pcon->p_ydb_so->p_ydb_cip(pdesc, DBX_CI_ARGS16(0), DBX_CI_ARGS16(16));
          break;
       default:
-         rc = CACHE_SUCCESS;
-         pfun->out.length = 0;
+         rc = pcon->p_ydb_so->p_ydb_cip(pdesc, DBX_CI_ARGS16(0), DBX_CI_ARGS16(16), DBX_CI_ARGS16(32), DBX_CI_ARGS16(48));
          break;
    }
 
@@ -4229,6 +6776,346 @@ int ydb_function_ex(DBXMETH *pmeth, DBXFUN *pfun)
 }
 
 
+int ydb_ci_free(DBXCON *pcon)
+{
+   if (!pcon->p_ci) {
+      return 0;
+   }
+
+   mg_free((void *) pcon->p_ci, 0);
+   pcon->p_ci = NULL;
+
+   return 1;
+}
+
+
+/*
+   v1.3.22: YottaDB SimpleThreadAPI
+
+   YottaDB does not allow the SimpleAPI and the SimpleThreadAPI to be mixed in the same process, so
+   the API is selected by the first connection opened and a later connection asking for the other is refused.
+   In SimpleThreadAPI mode the SimpleAPI entry points of each connection are replaced with the
+   ydb_thread_*() functions below, which pass the transaction token and error buffer held by
+   the calling thread.  Multi-node locks (ydb_lock_s) are not available in this mode, so these
+   revert to one lock call per node.
+*/
+
+int ydb_load_library_st(DBXCON *pcon)
+{
+   int result;
+   char fun[64];
+
+   result = CACHE_SUCCESS;
+   fun[0] = '\0';
+
+   mg_enter_critical_section((void *) &dbx_global_mutex);
+
+   if ((pcon->threaded && dbx_ydb_st.mode == 1) || (!pcon->threaded && dbx_ydb_st.mode == 2)) {
+      sprintf(pcon->error, "Error loading %s library: %s; The %s has been selected by the first connection in the process", pcon->p_ydb_so->dbname, pcon->p_ydb_so->libnam, dbx_ydb_st.mode == 2 ? "SimpleThreadAPI" : "SimpleAPI");
+      result = CACHE_NOCON;
+      goto ydb_load_library_st_exit;
+   }
+
+   if (dbx_ydb_st.mode == 0 && !pcon->threaded) {
+      dbx_ydb_st.mode = 1;
+   }
+   if (dbx_ydb_st.mode == 1) {
+      goto ydb_load_library_st_exit;
+   }
+
+   /* bind (or re-bind, if the library has since been reloaded) the SimpleThreadAPI functions */
+   sprintf(fun, "%s_data_st", pcon->p_ydb_so->funprfx);
+   dbx_ydb_st.p_ydb_data_st = (int (*) (unsigned long long, ydb_buffer_t *, ydb_buffer_t *, int, ydb_buffer_t *, unsigned int *)) mg_dso_sym(pcon->p_ydb_so->p_library, (char *) fun);
+   if (!dbx_ydb_st.p_ydb_data_st) {
+      goto ydb_load_library_st_exit;
+   }
+   sprintf(fun, "%s_delete_st", pcon->p_ydb_so->funprfx);
+   dbx_ydb_st.p_ydb_delete_st = (int (*) (unsigned long long, ydb_buffer_t *, ydb_buffer_t *, int, ydb_buffer_t *, int)) mg_dso_sym(pcon->p_ydb_so->p_library, (char *) fun);
+   if (!dbx_ydb_st.p_ydb_delete_st) {
+      goto ydb_load_library_st_exit;
+   }
+   sprintf(fun, "%s_set_st", pcon->p_ydb_so->funprfx);
+   dbx_ydb_st.p_ydb_set_st = (int (*) (unsigned long long, ydb_buffer_t *, ydb_buffer_t *, int, ydb_buffer_t *, ydb_buffer_t *)) mg_dso_sym(pcon->p_ydb_so->p_library, (char *) fun);
+   if (!dbx_ydb_st.p_ydb_set_st) {
+      goto ydb_load_library_st_exit;
+   }
+   sprintf(fun, "%s_get_st", pcon->p_ydb_so->funprfx);
+   dbx_ydb_st.p_ydb_get_st = (int (*) (unsigned long long, ydb_buffer_t *, ydb_buffer_t *, int, ydb_buffer_t *, ydb_buffer_t *)) mg_dso_sym(pcon->p_ydb_so->p_library, (char *) fun);
+   if (!dbx_ydb_st.p_ydb_get_st) {
+      goto ydb_load_library_st_exit;
+   }
+   sprintf(fun, "%s_subscript_next_st", pcon->p_ydb_so->funprfx);
+   dbx_ydb_st.p_ydb_subscript_next_st = (int (*) (unsigned long long, ydb_buffer_t *, ydb_buffer_t *, int, ydb_buffer_t *, ydb_buffer_t *)) mg_dso_sym(pcon->p_ydb_so->p_library, (char *) fun);
+   if (!dbx_ydb_st.p_ydb_subscript_next_st) {
+      goto ydb_load_library_st_exit;
+   }
+   sprintf(fun, "%s_subscript_previous_st", pcon->p_ydb_so->funprfx);
+   dbx_ydb_st.p_ydb_subscript_previous_st = (int (*) (unsigned long long, ydb_buffer_t *, ydb_buffer_t *, int, ydb_buffer_t *, ydb_buffer_t *)) mg_dso_sym(pcon->p_ydb_so->p_library, (char *) fun);
+   if (!dbx_ydb_st.p_ydb_subscript_previous_st) {
+      goto ydb_load_library_st_exit;
+   }
+   sprintf(fun, "%s_node_next_st", pcon->p_ydb_so->funprfx);
+   dbx_ydb_st.p_ydb_node_next_st = (int (*) (unsigned long long, ydb_buffer_t *, ydb_buffer_t *, int, ydb_buffer_t *, int *, ydb_buffer_t *)) mg_dso_sym(pcon->p_ydb_so->p_library, (char *) fun);
+   if (!dbx_ydb_st.p_ydb_node_next_st) {
+      goto ydb_load_library_st_exit;
+   }
+   sprintf(fun, "%s_node_previous_st", pcon->p_ydb_so->funprfx);
+   dbx_ydb_st.p_ydb_node_previous_st = (int (*) (unsigned long long, ydb_buffer_t *, ydb_buffer_t *, int, ydb_buffer_t *, int *, ydb_buffer_t *)) mg_dso_sym(pcon->p_ydb_so->p_library, (char *) fun);
+   if (!dbx_ydb_st.p_ydb_node_previous_st) {
+      goto ydb_load_library_st_exit;
+   }
+   sprintf(fun, "%s_incr_st", pcon->p_ydb_so->funprfx);
+   dbx_ydb_st.p_ydb_incr_st = (int (*) (unsigned long long, ydb_buffer_t *, ydb_buffer_t *, int, ydb_buffer_t *, ydb_buffer_t *, ydb_buffer_t *)) mg_dso_sym(pcon->p_ydb_so->p_library, (char *) fun);
+   if (!dbx_ydb_st.p_ydb_incr_st) {
+      goto ydb_load_library_st_exit;
+   }
+   sprintf(fun, "%s_cip_t", pcon->p_ydb_so->funprfx);
+   dbx_ydb_st.p_ydb_cip_t = (int (*) (unsigned long long, ydb_buffer_t *, ci_name_descriptor *, ...)) mg_dso_sym(pcon->p_ydb_so->p_library, (char *) fun);
+   if (!dbx_ydb_st.p_ydb_cip_t) {
+      goto ydb_load_library_st_exit;
+   }
+   sprintf(fun, "%s_lock_incr_st", pcon->p_ydb_so->funprfx);
+   dbx_ydb_st.p_ydb_lock_incr_st = (int (*) (unsigned long long, ydb_buffer_t *, unsigned long long, ydb_buffer_t *, int, ydb_buffer_t *)) mg_dso_sym(pcon->p_ydb_so->p_library, (char *) fun);
+   if (!dbx_ydb_st.p_ydb_lock_incr_st) {
+      goto ydb_load_library_st_exit;
+   }
+   sprintf(fun, "%s_lock_decr_st", pcon->p_ydb_so->funprfx);
+   dbx_ydb_st.p_ydb_lock_decr_st = (int (*) (unsigned long long, ydb_buffer_t *, ydb_buffer_t *, int, ydb_buffer_t *)) mg_dso_sym(pcon->p_ydb_so->p_library, (char *) fun);
+   if (!dbx_ydb_st.p_ydb_lock_decr_st) {
+      goto ydb_load_library_st_exit;
+   }
+   sprintf(fun, "%s_tp_st", pcon->p_ydb_so->funprfx);
+   dbx_ydb_st.p_ydb_tp_st = (int (*) (unsigned long long, ydb_buffer_t *, ydb_tp2fnptr_t, void *, const char *, int, ydb_buffer_t *)) mg_dso_sym(pcon->p_ydb_so->p_library, (char *) fun);
+   if (!dbx_ydb_st.p_ydb_tp_st) {
+      goto ydb_load_library_st_exit;
+   }
+
+   dbx_ydb_st.mode = 2;
+
+   pcon->p_ydb_so->threaded = 1;
+   pcon->p_ydb_so->p_ydb_data_s = ydb_thread_data;
+   pcon->p_ydb_so->p_ydb_delete_s = ydb_thread_delete;
+   pcon->p_ydb_so->p_ydb_set_s = ydb_thread_set;
+   pcon->p_ydb_so->p_ydb_get_s = ydb_thread_get;
+   pcon->p_ydb_so->p_ydb_subscript_next_s = ydb_thread_subscript_next;
+   pcon->p_ydb_so->p_ydb_subscript_previous_s = ydb_thread_subscript_previous;
+   pcon->p_ydb_so->p_ydb_node_next_s = ydb_thread_node_next;
+   pcon->p_ydb_so->p_ydb_node_previous_s = ydb_thread_node_previous;
+   pcon->p_ydb_so->p_ydb_incr_s = ydb_thread_incr;
+   pcon->p_ydb_so->p_ydb_lock_incr_s = ydb_thread_lock_incr;
+   pcon->p_ydb_so->p_ydb_lock_decr_s = ydb_thread_lock_decr;
+   pcon->p_ydb_so->p_ydb_lock_s = NULL;
+
+   fun[0] = '\0';
+
+ydb_load_library_st_exit:
+
+   mg_leave_critical_section((void *) &dbx_global_mutex);
+
+   if (fun[0]) {
+      sprintf(pcon->error, "Error loading %s library: %s; Cannot locate the following function : %s", pcon->p_ydb_so->dbname, pcon->p_ydb_so->libnam, fun);
+      result = CACHE_NOCON;
+   }
+
+   return result;
+}
+
+
+ydb_buffer_t * ydb_thread_errstr(ydb_buffer_t *errstr)
+{
+   dbx_ydb_errbuf[0] = '\0';
+   errstr->buf_addr = dbx_ydb_errbuf;
+   errstr->len_alloc = DBX_ERROR_SIZE - 1;
+   errstr->len_used = 0;
+
+   return errstr;
+}
+
+
+int ydb_thread_status(ydb_buffer_t *errstr, int rc)
+{
+   if (rc != YDB_OK && errstr->len_used > 0 && errstr->len_used < errstr->len_alloc) {
+      dbx_ydb_errbuf[errstr->len_used] = '\0';
+   }
+   else {
+      dbx_ydb_errbuf[0] = '\0';
+   }
+
+   return rc;
+}
+
+
+int ydb_thread_data(ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray, unsigned int *ret_value)
+{
+   int rc;
+   ydb_buffer_t errstr;
+
+   rc = dbx_ydb_st.p_ydb_data_st(dbx_ydb_tptoken, ydb_thread_errstr(&errstr), varname, subs_used, subsarray, ret_value);
+
+   return ydb_thread_status(&errstr, rc);
+}
+
+
+int ydb_thread_delete(ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray, int deltype)
+{
+   int rc;
+   ydb_buffer_t errstr;
+
+   rc = dbx_ydb_st.p_ydb_delete_st(dbx_ydb_tptoken, ydb_thread_errstr(&errstr), varname, subs_used, subsarray, deltype);
+
+   return ydb_thread_status(&errstr, rc);
+}
+
+
+int ydb_thread_set(ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray, ydb_buffer_t *value)
+{
+   int rc;
+   ydb_buffer_t errstr;
+
+   rc = dbx_ydb_st.p_ydb_set_st(dbx_ydb_tptoken, ydb_thread_errstr(&errstr), varname, subs_used, subsarray, value);
+
+   return ydb_thread_status(&errstr, rc);
+}
+
+
+int ydb_thread_get(ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray, ydb_buffer_t *ret_value)
+{
+   int rc;
+   ydb_buffer_t errstr;
+
+   rc = dbx_ydb_st.p_ydb_get_st(dbx_ydb_tptoken, ydb_thread_errstr(&errstr), varname, subs_used, subsarray, ret_value);
+
+   return ydb_thread_status(&errstr, rc);
+}
+
+
+int ydb_thread_subscript_next(ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray, ydb_buffer_t *ret_value)
+{
+   int rc;
+   ydb_buffer_t errstr;
+
+   rc = dbx_ydb_st.p_ydb_subscript_next_st(dbx_ydb_tptoken, ydb_thread_errstr(&errstr), varname, subs_used, subsarray, ret_value);
+
+   return ydb_thread_status(&errstr, rc);
+}
+
+
+int ydb_thread_subscript_previous(ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray, ydb_buffer_t *ret_value)
+{
+   int rc;
+   ydb_buffer_t errstr;
+
+   rc = dbx_ydb_st.p_ydb_subscript_previous_st(dbx_ydb_tptoken, ydb_thread_errstr(&errstr), varname, subs_used, subsarray, ret_value);
+
+   return ydb_thread_status(&errstr, rc);
+}
+
+
+int ydb_thread_node_next(ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray, int *ret_subs_used, ydb_buffer_t *ret_subsarray)
+{
+   int rc;
+   ydb_buffer_t errstr;
+
+   rc = dbx_ydb_st.p_ydb_node_next_st(dbx_ydb_tptoken, ydb_thread_errstr(&errstr), varname, subs_used, subsarray, ret_subs_used, ret_subsarray);
+
+   return ydb_thread_status(&errstr, rc);
+}
+
+
+int ydb_thread_node_previous(ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray, int *ret_subs_used, ydb_buffer_t *ret_subsarray)
+{
+   int rc;
+   ydb_buffer_t errstr;
+
+   rc = dbx_ydb_st.p_ydb_node_previous_st(dbx_ydb_tptoken, ydb_thread_errstr(&errstr), varname, subs_used, subsarray, ret_subs_used, ret_subsarray);
+
+   return ydb_thread_status(&errstr, rc);
+}
+
+
+int ydb_thread_incr(ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray, ydb_buffer_t *increment, ydb_buffer_t *ret_value)
+{
+   int rc;
+   ydb_buffer_t errstr;
+
+   rc = dbx_ydb_st.p_ydb_incr_st(dbx_ydb_tptoken, ydb_thread_errstr(&errstr), varname, subs_used, subsarray, increment, ret_value);
+
+   return ydb_thread_status(&errstr, rc);
+}
+
+
+int ydb_thread_lock_incr(unsigned long long timeout_nsec, ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray)
+{
+   int rc;
+   ydb_buffer_t errstr;
+
+   rc = dbx_ydb_st.p_ydb_lock_incr_st(dbx_ydb_tptoken, ydb_thread_errstr(&errstr), timeout_nsec, varname, subs_used, subsarray);
+
+   return ydb_thread_status(&errstr, rc);
+}
+
+
+int ydb_thread_lock_decr(ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray)
+{
+   int rc;
+   ydb_buffer_t errstr;
+
+   rc = dbx_ydb_st.p_ydb_lock_decr_st(dbx_ydb_tptoken, ydb_thread_errstr(&errstr), varname, subs_used, subsarray);
+
+   return ydb_thread_status(&errstr, rc);
+}
+
+
+
+/* v1.3.22: execute a request within the transaction */
+int ydb_transaction_exec(DBXMETH *pmeth, int context)
+{
+   int rc;
+
+   rc = YDB_OK;
+   if (context == YDB_TPCTX_DB) {
+      rc = pmeth->p_dbxfun(pmeth);
+   }
+   else if (context == YDB_TPCTX_FUN) {
+      rc = ydb_function_ex(pmeth, pmeth->pfun);
+   }
+   else if (context == YDB_TPCTX_QUERY) {
+      if (pmeth->pfun->dir == 1) {
+         pmeth->pfun->rc = pmeth->pcon->p_ydb_so->p_ydb_node_next_s(pmeth->pfun->global, pmeth->pfun->in_nkeys, pmeth->pfun->in_keys, pmeth->pfun->out_nkeys, pmeth->pfun->out_keys);
+      }
+      else {
+         pmeth->pfun->rc = pmeth->pcon->p_ydb_so->p_ydb_node_previous_s(pmeth->pfun->global, pmeth->pfun->in_nkeys, pmeth->pfun->in_keys, pmeth->pfun->out_nkeys, pmeth->pfun->out_keys);
+      }
+      if (pmeth->pfun->getdata && pmeth->pfun->rc == YDB_OK && *(pmeth->pfun->out_nkeys) != YDB_NODE_END) {
+         pmeth->pfun->rc = pmeth->pcon->p_ydb_so->p_ydb_get_s(pmeth->pfun->global, *(pmeth->pfun->out_nkeys), pmeth->pfun->out_keys, pmeth->pfun->data);
+      }
+   }
+   else if (context == YDB_TPCTX_ORDER) {
+      if (pmeth->pfun->dir == 1) {
+         pmeth->pfun->rc = pmeth->pcon->p_ydb_so->p_ydb_subscript_next_s(pmeth->pfun->global, pmeth->pfun->in_nkeys, pmeth->pfun->in_keys, pmeth->pfun->out_keys);
+      }
+      else {
+         pmeth->pfun->rc = pmeth->pcon->p_ydb_so->p_ydb_subscript_previous_s(pmeth->pfun->global, pmeth->pfun->in_nkeys, pmeth->pfun->in_keys, pmeth->pfun->out_keys);
+      }
+      if (pmeth->pfun->rc == CACHE_SUCCESS && pmeth->pfun->out_keys->len_used > 0) {
+         strcpy((pmeth->pfun->in_keys + (pmeth->pfun->in_nkeys - 1))->buf_addr, pmeth->pfun->out_keys->buf_addr);
+         (pmeth->pfun->in_keys + (pmeth->pfun->in_nkeys - 1))->len_used = pmeth->pfun->out_keys->len_used;
+         if (pmeth->pfun->getdata) {
+            pmeth->pfun->rc = pmeth->pcon->p_ydb_so->p_ydb_get_s(pmeth->pfun->global, pmeth->pfun->in_nkeys, pmeth->pfun->in_keys, pmeth->pfun->data);
+         }
+      }
+      else {
+         (pmeth->pfun->in_keys + (pmeth->pfun->in_nkeys - 1))->len_used = 0;
+      }
+   }
+   else if (context == YDB_TPCTX_TLEVEL) {
+      pmeth->output_val.num.int32 = ydb_get_intsvar(pmeth->pcon, (char *) "$tlevel");
+   }
+
+   return rc;
+}
+
+
 /* v1.2.9 */
 int ydb_transaction_cb(void *pargs)
 {
@@ -4278,44 +7165,7 @@ int ydb_transaction_cb(void *pargs)
       if (pthrt->context) {
          context = pthrt->context;
          pthrt->context = 0;
-         if (context == YDB_TPCTX_DB) {
-            rc = pmeth->p_dbxfun(pmeth);
-         }
-         else if (context == YDB_TPCTX_FUN) {
-            rc = ydb_function_ex(pmeth, pmeth->pfun);
-         }
-         else if (context == YDB_TPCTX_QUERY) {
-            if (pmeth->pfun->dir == 1) {
-               pmeth->pfun->rc = pmeth->pcon->p_ydb_so->p_ydb_node_next_s(pmeth->pfun->global, pmeth->pfun->in_nkeys, pmeth->pfun->in_keys, pmeth->pfun->out_nkeys, pmeth->pfun->out_keys);
-            }
-            else {
-               pmeth->pfun->rc = pmeth->pcon->p_ydb_so->p_ydb_node_previous_s(pmeth->pfun->global, pmeth->pfun->in_nkeys, pmeth->pfun->in_keys, pmeth->pfun->out_nkeys, pmeth->pfun->out_keys);
-            }
-            if (pmeth->pfun->getdata && pmeth->pfun->rc == YDB_OK && *(pmeth->pfun->out_nkeys) != YDB_NODE_END) {
-               pmeth->pfun->rc = pmeth->pcon->p_ydb_so->p_ydb_get_s(pmeth->pfun->global, *(pmeth->pfun->out_nkeys), pmeth->pfun->out_keys, pmeth->pfun->data);
-            }
-         }
-         else if (context == YDB_TPCTX_ORDER) {
-            if (pmeth->pfun->dir == 1) {
-               pmeth->pfun->rc = pmeth->pcon->p_ydb_so->p_ydb_subscript_next_s(pmeth->pfun->global, pmeth->pfun->in_nkeys, pmeth->pfun->in_keys, pmeth->pfun->out_keys);
-            }
-            else {
-               pmeth->pfun->rc = pmeth->pcon->p_ydb_so->p_ydb_subscript_previous_s(pmeth->pfun->global, pmeth->pfun->in_nkeys, pmeth->pfun->in_keys, pmeth->pfun->out_keys);
-            }
-            if (pmeth->pfun->rc == CACHE_SUCCESS && pmeth->pfun->out_keys->len_used > 0) {
-               strcpy((pmeth->pfun->in_keys + (pmeth->pfun->in_nkeys - 1))->buf_addr, pmeth->pfun->out_keys->buf_addr);
-               (pmeth->pfun->in_keys + (pmeth->pfun->in_nkeys - 1))->len_used = pmeth->pfun->out_keys->len_used;
-               if (pmeth->pfun->getdata) {
-                  pmeth->pfun->rc = pmeth->pcon->p_ydb_so->p_ydb_get_s(pmeth->pfun->global, pmeth->pfun->in_nkeys, pmeth->pfun->in_keys, pmeth->pfun->data);
-               }
-            }
-            else {
-               (pmeth->pfun->in_keys + (pmeth->pfun->in_nkeys - 1))->len_used = 0;
-            }
-         }
-         else if (context == YDB_TPCTX_TLEVEL) {
-            pmeth->output_val.num.int32 = ydb_get_intsvar(pmeth->pcon, (char *) "$tlevel");
-         }
+         rc = ydb_transaction_exec(pmeth, context);
          pthrt->done = 1;
          pthread_cond_broadcast(&(pthrt->res_cv));
 
@@ -4338,6 +7188,25 @@ int ydb_transaction_cb(void *pargs)
 }
 
 
+/* v1.3.22: SimpleThreadAPI transactions are identified by the token passed to the callback */
+int ydb_transaction_cb_st(unsigned long long tptoken, ydb_buffer_t *errstr, void *pargs)
+{
+   int rc;
+   unsigned long long tptoken_saved;
+   DBXTHRT *pthrt;
+
+   pthrt = (DBXTHRT *) pargs;
+   pthrt->tptoken = tptoken;
+
+   tptoken_saved = dbx_ydb_tptoken;
+   dbx_ydb_tptoken = tptoken;
+   rc = ydb_transaction_cb(pargs);
+   dbx_ydb_tptoken = tptoken_saved;
+
+   return rc;
+}
+
+
 #if defined(_WIN32)
 LPTHREAD_START_ROUTINE ydb_transaction_thread(LPVOID pargs)
 #else
@@ -4355,8 +7224,15 @@ void * ydb_transaction_thread(void *pargs)
    vnames[0].len_alloc = 0;
    vnames[0].len_used = 0;
 
-   pthrt->pmeth->pcon->p_ydb_so->p_ydb_tp_s((ydb_tpfnptr_t) ydb_transaction_cb, (void *) pthrt, (const char *) "mg-dbx", 0, &vnames[0]);
-/*
+   if (pthrt->pmeth->pcon->p_ydb_so->threaded) { /* v1.3.22 */
+      ydb_buffer_t errstr;
+
+      dbx_ydb_st.p_ydb_tp_st(pthrt->tptoken, ydb_thread_errstr(&errstr), (ydb_tp2fnptr_t) ydb_transaction_cb_st, (void *) pthrt, (const char *) "mg-dbx", 0, &vnames[0]);
+   }
+   else {
+      pthrt->pmeth->pcon->p_ydb_so->p_ydb_tp_s((ydb_tpfnptr_t) ydb_transaction_cb, (void *) pthrt, (const char *) "mg-dbx", 0, &vnames[0]);
+   }
+/*
    printf("\r\n*** ydb_transaction_thread EXIT tid=%lu ...", (unsigned long) dbx_current_thread_id());
 */
 
@@ -4394,6 +7270,11 @@ int ydb_transaction(DBXMETH *pmeth)
    mg_enter_critical_section((void *) &dbx_global_mutex);
    pmeth->pcon->tlevel ++;
    pmeth->pcon->pthrt[pmeth->pcon->tlevel] = (void *) pthrt;
+   /* v1.3.22: a nested SimpleThreadAPI transaction is started with the token of the enclosing one */
+   if (pmeth->pcon->tlevel > 1 && pmeth->pcon->pthrt[pmeth->pcon->tlevel - 1])
+      pthrt->tptoken = ((DBXTHRT *) pmeth->pcon->pthrt[pmeth->pcon->tlevel - 1])->tptoken;
+   else
+      pthrt->tptoken = YDB_NOTTP;
    mg_leave_critical_section((void *) &dbx_global_mutex);
 
    pthread_attr_init(&attr);
@@ -4434,12 +7315,29 @@ int ydb_transaction_task(DBXMETH *pmeth, int context)
    return 0;
 #else
    int rc;
+   unsigned long long tptoken_saved;
    DBXTHRT *pthrt;
    struct timespec   ts;
    struct timeval    tp;
 
    rc = YDB_OK;
    pthrt = (DBXTHRT *) pmeth->pcon->pthrt[pmeth->pcon->tlevel];
+
+   /* v1.3.22: once it has been passed on the request must run to completion, so check its deadline first */
+   if (context == YDB_TPCTX_DB && mg_deadline_ms(pmeth->pcon) == 0) {
+      return DBX_DEADLINE_EXCEEDED;
+   }
+
+   /* v1.3.22: under the SimpleThreadAPI the request can be run in this thread using the transaction's token */
+   if (pmeth->pcon->p_ydb_so->threaded && context != YDB_TPCTX_COMMIT && context != YDB_TPCTX_ROLLBACK) {
+      tptoken_saved = dbx_ydb_tptoken;
+      dbx_ydb_tptoken = pthrt->tptoken;
+      rc = ydb_transaction_exec(pmeth, context);
+      dbx_ydb_tptoken = tptoken_saved;
+      return (context == YDB_TPCTX_DB) ? rc : YDB_OK;
+   }
+
+   pthrt->done = 0; /* v1.3.22: reset before the request is signalled, otherwise the response may be missed */
    pthrt->context = context;
    pthrt->pmeth = pmeth;
 
@@ -4447,8 +7345,6 @@ int ydb_transaction_task(DBXMETH *pmeth, int context)
    pthread_cond_signal(&(pthrt->req_cv));
    pthread_mutex_unlock(&(pthrt->req_cv_mutex));
 
-   pthrt->done = 0;
-
    pthread_mutex_lock(&(pthrt->res_cv_mutex));
    while (!pthrt->done) {
       gettimeofday(&tp, NULL);
@@ -4645,14 +7541,6 @@ int gtm_open(DBXMETH *pmeth)
       pcon->p_gtm_so->loaded = 0;
    }
 
-   if (pcon->p_gtm_so->loaded == 2) {
-      strcpy(pcon->error, "Cannot create multiple connections to the database");
-      pcon->error_code = 1009; 
-      strcpy((char *) pmeth->output_val.svalue.buf_addr, "0");
-      rc = CACHE_NOCON;
-      goto gtm_open_exit;
-   }
-
    if (!pcon->p_gtm_so->loaded) {
       rc = gtm_load_library(pcon);
       sprintf((char *) pmeth->output_val.svalue.buf_addr, "%d", rc);
@@ -4780,6 +7668,8 @@ DBXMETH * mg_unpack_header(unsigned char *input, unsigned char *output)
    pmeth = (DBXMETH *) pcon->pmeth_base;
    pmeth->pcon = pcon;
 
+   mg_arena_reset(pcon); /* v1.3.22: release anything left by a request that did not end with mg_cleanup() */
+
    pmeth->argc = 0;
    pmeth->input_str.buf_addr = (char *) input;
    pmeth->input_str.len_used = len;
@@ -4819,6 +7709,7 @@ int mg_unpack_arguments(DBXMETH *pmeth)
       }
 
       pmeth->args[pmeth->argc].type = dtype;
+      pmeth->args[pmeth->argc].sort = dsort; /* v1.3.22 */
       pmeth->args[pmeth->argc].realloc = 0;
       pmeth->args[pmeth->argc].svalue.len_used = len;
       pmeth->args[pmeth->argc].svalue.buf_addr = (char *) (pmeth->input_str.buf_addr + pmeth->offset);
@@ -4939,6 +7830,9 @@ int mg_global_reference(DBXMETH *pmeth)
          if (pmeth->lock && last_arg) { /* v1.3.13: don't push lock timeout */
             continue;
          }
+         if (pmeth->query && last_arg) { /* v1.3.18: don't push the maximum number of nodes to return */
+            continue;
+         }
 
          if (pmeth->args[n].type == DBX_DTYPE_INT) {
             rc = pcon->p_isc_so->p_CachePushInt(pmeth->args[n].num.int32);
@@ -4976,7 +7870,7 @@ int mg_global_reference(DBXMETH *pmeth)
 
 int mg_class_reference(DBXMETH *pmeth, short context)
 {
-   int n, rc, len, dsort, dtype, flags;
+   int n, rc, len, dsort, dtype, flags, oref;
    unsigned int ne;
    DBXCON *pcon = pmeth->pcon;
 
@@ -5043,7 +7937,10 @@ int mg_class_reference(DBXMETH *pmeth, short context)
       }
       else if (context == 3) { /* v1.3.13: close instance */
          if (n == 0) {
-            rc = pcon->p_isc_so->p_CacheCloseOref((int) strtol(pmeth->args[0].svalue.buf_addr, NULL, 10));
+            oref = (int) strtol(pmeth->args[0].svalue.buf_addr, NULL, 10);
+            if (mg_oref_release(pcon, oref) <= 0) { /* v1.3.22: close when the last reference is released */
+               rc = pcon->p_isc_so->p_CacheCloseOref(oref);
+            }
             break;
          }
       }
@@ -5082,6 +7979,7 @@ int mg_function_reference(DBXMETH *pmeth, DBXFUN *pfun)
 {
    int n, rc, len, dsort, dtype;
    unsigned int ne;
+   DBXFREF *pfref;
    DBXCON *pcon = pmeth->pcon;
 
    rc = CACHE_SUCCESS;
@@ -5115,17 +8013,35 @@ int mg_function_reference(DBXMETH *pmeth, DBXFUN *pfun)
       }
 
       if (n == 0) {
-         strncpy(pfun->buffer, pmeth->args[n].svalue.buf_addr, pmeth->args[n].svalue.len_used);
-         pfun->buffer[pmeth->args[n].svalue.len_used] = '\0';
-         pfun->label = pfun->buffer;
-         pfun->routine = strstr(pfun->buffer, "^");
-         *pfun->routine = '\0';
-         pfun->routine ++;
-         pfun->label_len = (int) strlen(pfun->label);
-         pfun->routine_len = (int) strlen(pfun->routine);
-
-         if (pcon->dbtype != DBX_DBTYPE_YOTTADB) {
-            rc = pcon->p_isc_so->p_CachePushFunc(&(pfun->rflag), (int) pfun->label_len, (const Callin_char_t *) pfun->label, (int) pfun->routine_len, (const Callin_char_t *) pfun->routine);
+         pfref = mg_function_cache(pcon, pmeth->args[n].svalue.buf_addr, (int) pmeth->args[n].svalue.len_used); /* v1.3.22 */
+         if (pfref) {
+            pfun->label = pfref->buffer;
+            pfun->label_len = pfref->label_len;
+            pfun->routine = pfref->buffer + pfref->label_len + 1;
+            pfun->routine_len = pfref->routine_len;
+
+            if (pcon->dbtype != DBX_DBTYPE_YOTTADB) {
+               rc = pcon->p_isc_so->p_CachePushFunc(&(pfref->rflag), (int) pfun->label_len, (const Callin_char_t *) pfun->label, (int) pfun->routine_len, (const Callin_char_t *) pfun->routine);
+               if (rc != CACHE_SUCCESS && pfref->rflag) {
+                  pfref->rflag = 0;
+                  rc = pcon->p_isc_so->p_CachePushFunc(&(pfref->rflag), (int) pfun->label_len, (const Callin_char_t *) pfun->label, (int) pfun->routine_len, (const Callin_char_t *) pfun->routine);
+               }
+               pfun->rflag = pfref->rflag;
+            }
+         }
+         else {
+            strncpy(pfun->buffer, pmeth->args[n].svalue.buf_addr, pmeth->args[n].svalue.len_used);
+            pfun->buffer[pmeth->args[n].svalue.len_used] = '\0';
+            pfun->label = pfun->buffer;
+            pfun->routine = strstr(pfun->buffer, "^");
+            *pfun->routine = '\0';
+            pfun->routine ++;
+            pfun->label_len = (int) strlen(pfun->label);
+            pfun->routine_len = (int) strlen(pfun->routine);
+
+            if (pcon->dbtype != DBX_DBTYPE_YOTTADB) {
+               rc = pcon->p_isc_so->p_CachePushFunc(&(pfun->rflag), (int) pfun->label_len, (const Callin_char_t *) pfun->label, (int) pfun->routine_len, (const Callin_char_t *) pfun->routine);
+            }
          }
       }
       else {
@@ -5165,6 +8081,211 @@ int mg_function_reference(DBXMETH *pmeth, DBXFUN *pfun)
 }
 
 
+/* v1.3.22: return the parsed form of a function reference (label^routine), adding it to the connection's cache if necessary */
+DBXFREF * mg_function_cache(DBXCON *pcon, char *ref, int ref_len)
+{
+   int n;
+   char *p;
+   DBXFREF *pfref;
+   DBXFREFTAB *pfreftab;
+
+   if (ref_len < 3 || ref_len >= DBX_FREF_SIZE) {
+      return NULL;
+   }
+
+   pfreftab = (DBXFREFTAB *) pcon->p_fref;
+   if (!pfreftab) {
+      pfreftab = (DBXFREFTAB *) mg_malloc(sizeof(DBXFREFTAB), 0);
+      if (!pfreftab) {
+         return NULL;
+      }
+      pfreftab->used = 0;
+      pfreftab->next = 0;
+      pcon->p_fref = (void *) pfreftab;
+   }
+
+   for (n = 0; n < pfreftab->used; n ++) {
+      pfref = &(pfreftab->fref[n]);
+      if (pfref->ref_len == ref_len && !strncmp(pfref->ref, ref, ref_len)) {
+         return pfref;
+      }
+   }
+
+   p = (char *) memchr((void *) ref, '^', (size_t) ref_len);
+   if (!p) {
+      return NULL;
+   }
+
+   if (pfreftab->used < DBX_FREF_MAX) {
+      n = pfreftab->used ++;
+   }
+   else {
+      n = pfreftab->next;
+      pfreftab->next = (pfreftab->next + 1) % DBX_FREF_MAX;
+   }
+   pfref = &(pfreftab->fref[n]);
+   memcpy((void *) pfref->ref, (void *) ref, (size_t) ref_len);
+   pfref->ref[ref_len] = '\0';
+   pfref->ref_len = ref_len;
+   memcpy((void *) pfref->buffer, (void *) ref, (size_t) ref_len);
+   pfref->buffer[ref_len] = '\0';
+   pfref->label_len = (int) (p - ref);
+   pfref->buffer[pfref->label_len] = '\0';
+   pfref->routine_len = ref_len - (pfref->label_len + 1);
+   pfref->rflag = 0;
+
+   return pfref;
+}
+
+
+/* v1.3.22: context 0 - invalidate the cached function references (e.g. on change of namespace); context 1 - free the cache */
+int mg_function_cache_clear(DBXCON *pcon, int context)
+{
+   DBXFREFTAB *pfreftab;
+
+   pfreftab = (DBXFREFTAB *) pcon->p_fref;
+   if (!pfreftab) {
+      return 0;
+   }
+
+   if (context == 0) {
+      pfreftab->used = 0;
+      pfreftab->next = 0;
+   }
+   else {
+      mg_free((void *) pfreftab, 0);
+      pcon->p_fref = NULL;
+   }
+
+   return 1;
+}
+
+
+#define DBX_OREF_HASH(OREF, MASK) ((int) (((unsigned int) (OREF) * 2654435761U) & (MASK)))
+
+/* v1.3.22: record a reference to an OREF held by the connection and return the number of references now held */
+int mg_oref_add(DBXCON *pcon, int oref)
+{
+   int n, size, mask;
+   DBXOREF *porefs;
+   DBXOREFTAB *preftab;
+
+   if (oref < 1) {
+      return 0;
+   }
+
+   preftab = (DBXOREFTAB *) pcon->p_oref;
+   if (!preftab) {
+      preftab = (DBXOREFTAB *) mg_malloc(sizeof(DBXOREFTAB), 0);
+      if (!preftab) {
+         return 0;
+      }
+      preftab->orefs = (DBXOREF *) mg_malloc(sizeof(DBXOREF) * DBX_OREF_SIZE, 0);
+      if (!preftab->orefs) {
+         mg_free((void *) preftab, 0);
+         return 0;
+      }
+      memset((void *) preftab->orefs, 0, sizeof(DBXOREF) * DBX_OREF_SIZE);
+      preftab->size = DBX_OREF_SIZE;
+      preftab->used = 0;
+      pcon->p_oref = (void *) preftab;
+   }
+
+   if ((preftab->used + 1) * 2 > preftab->size) { /* keep the table at most half full */
+      size = preftab->size * 2;
+      porefs = (DBXOREF *) mg_malloc(sizeof(DBXOREF) * size, 0);
+      if (!porefs) {
+         return 0;
+      }
+      memset((void *) porefs, 0, sizeof(DBXOREF) * size);
+      mask = size - 1;
+      for (n = 0; n < preftab->size; n ++) {
+         int h;
+
+         if (preftab->orefs[n].oref == 0) {
+            continue;
+         }
+         for (h = DBX_OREF_HASH(preftab->orefs[n].oref, mask); porefs[h].oref; h = (h + 1) & mask)
+            ;
+         porefs[h] = preftab->orefs[n];
+      }
+      mg_free((void *) preftab->orefs, 0);
+      preftab->orefs = porefs;
+      preftab->size = size;
+   }
+
+   mask = preftab->size - 1;
+   for (n = DBX_OREF_HASH(oref, mask); preftab->orefs[n].oref; n = (n + 1) & mask) {
+      if (preftab->orefs[n].oref == oref) {
+         return ++ preftab->orefs[n].refs;
+      }
+   }
+   preftab->orefs[n].oref = oref;
+   preftab->orefs[n].refs = 1;
+   preftab->used ++;
+
+   return 1;
+}
+
+
+/* v1.3.22: release a reference to an OREF and return the number of references still held (-1 if the OREF is not held) */
+int mg_oref_release(DBXCON *pcon, int oref)
+{
+   int n, h, next, mask;
+   DBXOREFTAB *preftab;
+
+   preftab = (DBXOREFTAB *) pcon->p_oref;
+   if (!preftab || oref < 1) {
+      return -1;
+   }
+
+   mask = preftab->size - 1;
+   for (n = DBX_OREF_HASH(oref, mask); preftab->orefs[n].oref; n = (n + 1) & mask) {
+      if (preftab->orefs[n].oref == oref) {
+         break;
+      }
+   }
+   if (preftab->orefs[n].oref == 0) {
+      return -1;
+   }
+   if (-- preftab->orefs[n].refs > 0) {
+      return preftab->orefs[n].refs;
+   }
+
+   /* Remove the entry, moving back any later entries in the same run that would no longer be found */
+   for (next = (n + 1) & mask; preftab->orefs[next].oref; next = (next + 1) & mask) {
+      h = DBX_OREF_HASH(preftab->orefs[next].oref, mask);
+      if ((n < next) ? (h > n && h <= next) : (h > n || h <= next)) {
+         continue;
+      }
+      preftab->orefs[n] = preftab->orefs[next];
+      n = next;
+   }
+   preftab->orefs[n].oref = 0;
+   preftab->orefs[n].refs = 0;
+   preftab->used --;
+
+   return 0;
+}
+
+
+int mg_oref_free(DBXCON *pcon)
+{
+   DBXOREFTAB *preftab;
+
+   preftab = (DBXOREFTAB *) pcon->p_oref;
+   if (!preftab) {
+      return 0;
+   }
+
+   mg_free((void *) preftab->orefs, 0);
+   mg_free((void *) preftab, 0);
+   pcon->p_oref = NULL;
+
+   return 1;
+}
+
+
 int mg_add_block_head(DBXSTR *block, unsigned long buffer_size, unsigned long index)
 {
    block->len_used = 0;
@@ -5303,14 +8424,28 @@ int mg_buf_init(MGBUF *p_buf, int size, int increment_size)
 
 int mg_buf_resize(MGBUF *p_buf, unsigned long size)
 {
-   if (size < MG_BUFSIZE)
-      return 1;
+   unsigned long csize;
+   unsigned char *p;
 
-   if (size < p_buf->size)
+   if (size <= p_buf->size)
       return 1;
 
-   p_buf->p_buffer = (unsigned char *) mg_realloc((void *) p_buf->p_buffer, 0, sizeof(char) * size, 0);
-   p_buf->size = size;
+   /* v1.3.22: grow geometrically and keep the current contents */
+   csize = p_buf->size ? p_buf->size : MG_BUFSIZE;
+   while (csize < size)
+      csize *= 2;
+
+   p = (unsigned char *) mg_malloc(sizeof(char) * (csize + 1), 0);
+   if (!p)
+      return 0;
+
+   if (p_buf->p_buffer) {
+      memcpy((void *) p, (void *) p_buf->p_buffer, p_buf->data_size);
+      mg_free((void *) p_buf->p_buffer, 0);
+   }
+   p[p_buf->data_size] = '\0';
+   p_buf->p_buffer = p;
+   p_buf->size = csize;
 
    return 1;
 }
@@ -5370,8 +8505,7 @@ int mg_buf_cpy(LPMGBUF p_buf, char *buffer, unsigned long size)
 
 int mg_buf_cat(LPMGBUF p_buf, char *buffer, unsigned long size)
 {
-   unsigned long int result, req_size, csize, tsize, increment_size;
-   unsigned char *p_temp;
+   unsigned long int result, req_size, tsize;
 
    result = 1;
 
@@ -5381,25 +8515,10 @@ int mg_buf_cat(LPMGBUF p_buf, char *buffer, unsigned long size)
    if (size == 0)
       return result;
 
-   p_temp = NULL;
    req_size = (size + p_buf->data_size);
    tsize = p_buf->data_size;
    if (req_size > p_buf->size) {
-      csize = p_buf->size;
-      increment_size = p_buf->increment_size;
-      while (req_size > csize)
-         csize = csize + p_buf->increment_size;
-      p_temp = p_buf->p_buffer;
-      result = mg_buf_init(p_buf, (int) csize, (int) increment_size);
-      if (result) {
-         if (p_temp) {
-            memcpy((void *) p_buf->p_buffer, (void *) p_temp, tsize);
-            p_buf->data_size = tsize;
-            mg_free((void *) p_temp, 0);
-         }
-      }
-      else
-         p_buf->p_buffer = p_temp;
+      result = mg_buf_resize(p_buf, req_size); /* v1.3.22 */
    }
    if (result) {
       memcpy((void *) (p_buf->p_buffer + tsize), (void *) buffer, size);
@@ -5457,6 +8576,66 @@ void * mg_malloc(int size, short id)
 }
 
 
+/* v1.3.22 */
+void * mg_arena_alloc(DBXCON *pcon, unsigned long size)
+{
+   unsigned char *p;
+   DBXARENA *parena = &(pcon->arena);
+
+   size = (size + 15) & ~((unsigned long) 15);
+
+   if (!parena->p_block) {
+      parena->p_block = (unsigned char *) mg_malloc(DBX_ARENA_SIZE, 0);
+      parena->size = parena->p_block ? DBX_ARENA_SIZE : 0;
+      parena->used = 0;
+   }
+   if ((parena->used + size) <= parena->size) {
+      p = parena->p_block + parena->used;
+      parena->used += size;
+      return (void *) p;
+   }
+
+   p = (unsigned char *) mg_malloc((int) (size + 16), 0);
+   if (!p) {
+      return NULL;
+   }
+   *((void **) p) = parena->p_overflow;
+   parena->p_overflow = (void *) p;
+   parena->overflows ++;
+
+   return (void *) (p + 16);
+}
+
+
+int mg_arena_reset(DBXCON *pcon)
+{
+   void *p, *pnext;
+   DBXARENA *parena = &(pcon->arena);
+
+   for (p = parena->p_overflow; p; p = pnext) {
+      pnext = *((void **) p);
+      mg_free(p, 0);
+   }
+   parena->p_overflow = NULL;
+   parena->used = 0;
+
+   return 1;
+}
+
+
+int mg_arena_free(DBXCON *pcon)
+{
+   mg_arena_reset(pcon);
+   if (pcon->arena.p_block) {
+      mg_free((void *) pcon->arena.p_block, 0);
+   }
+   pcon->arena.p_block = NULL;
+   pcon->arena.size = 0;
+
+   return 1;
+}
+
+
 int mg_free(void *p, short id)
 {
    /* printf("\nmg_free: id=%d; p=%p;", id, p); */
@@ -5500,6 +8679,30 @@ int mg_lcase(char *string)
 }
 
 
+int mg_ucase(char *string)
+{
+#ifdef _UNICODE
+
+   CharUpperA(string);
+   return 1;
+
+#else
+
+   int n, chr;
+
+   n = 0;
+   while (string[n] != '\0') {
+      chr = (int) string[n];
+      if (chr >= 97 && chr <= 122)
+         string[n] = (char) (chr - 32);
+      n ++;
+   }
+   return 1;
+
+#endif
+}
+
+
 int mg_create_string(DBXMETH *pmeth, void *data, short type)
 {
    int len;
@@ -5774,6 +8977,108 @@ int mg_dso_unload(DBXPLIB p_library)
 }
 
 
+/* v1.3.22: return (and take a reference to) a library already loaded for this type of database and installation */
+void * mg_library_get(DBXCON *pcon)
+{
+   int dbtype;
+   void *p_so;
+   DBXLIBREG *preg;
+
+   dbtype = (pcon->dbtype == DBX_DBTYPE_YOTTADB) ? DBX_DBTYPE_YOTTADB : DBX_DBTYPE_IRIS;
+   p_so = NULL;
+
+   mg_enter_critical_section((void *) &dbx_global_mutex);
+   for (preg = dbx_lib_list; preg; preg = preg->pnext) {
+      if (preg->dbtype == dbtype && !strcmp(preg->shdir, pcon->shdir)) {
+         preg->refs ++;
+         p_so = preg->p_so;
+         break;
+      }
+   }
+   mg_leave_critical_section((void *) &dbx_global_mutex);
+
+   return p_so;
+}
+
+
+/* v1.3.22: register a library newly loaded by this connection */
+int mg_library_add(DBXCON *pcon, void *p_so)
+{
+   DBXLIBREG *preg;
+
+   preg = (DBXLIBREG *) mg_malloc(sizeof(DBXLIBREG), 0);
+   if (!preg) {
+      return 0;
+   }
+   preg->dbtype = (pcon->dbtype == DBX_DBTYPE_YOTTADB) ? DBX_DBTYPE_YOTTADB : DBX_DBTYPE_IRIS;
+   preg->refs = 1;
+   strncpy(preg->shdir, pcon->shdir, 255);
+   preg->shdir[255] = '\0';
+   preg->p_so = p_so;
+
+   mg_enter_critical_section((void *) &dbx_global_mutex);
+   preg->pnext = dbx_lib_list;
+   dbx_lib_list = preg;
+   mg_leave_critical_section((void *) &dbx_global_mutex);
+
+   return 1;
+}
+
+
+/*
+   v1.3.22: release the connection's reference to its library.
+   An InterSystems library is unloaded when its last reference is released.  A YottaDB library is
+   never unloaded (the runtime cannot be restarted in the same process) so its entry is kept for reuse.
+*/
+int mg_library_release(DBXCON *pcon)
+{
+   int refs;
+   void *p_so;
+   DBXLIBREG *preg, *pprev;
+
+   p_so = (pcon->dbtype == DBX_DBTYPE_YOTTADB) ? (void *) pcon->p_ydb_so : (void *) pcon->p_isc_so;
+   if (!p_so) {
+      return 0;
+   }
+
+   refs = -1;
+   pprev = NULL;
+   mg_enter_critical_section((void *) &dbx_global_mutex);
+   for (preg = dbx_lib_list; preg; pprev = preg, preg = preg->pnext) {
+      if (preg->p_so == p_so) {
+         if (preg->refs > 0) {
+            preg->refs --;
+         }
+         refs = preg->refs;
+         if (refs == 0 && preg->dbtype != DBX_DBTYPE_YOTTADB) {
+            if (pprev)
+               pprev->pnext = preg->pnext;
+            else
+               dbx_lib_list = preg->pnext;
+            mg_free((void *) preg, 0);
+         }
+         break;
+      }
+   }
+   mg_leave_critical_section((void *) &dbx_global_mutex);
+
+   if (pcon->dbtype == DBX_DBTYPE_YOTTADB) {
+      pcon->p_ydb_so = NULL;
+      return refs;
+   }
+
+   if (refs <= 0) { /* last reference, or a library that was never registered */
+      if (pcon->p_isc_so->p_library) {
+         mg_dso_unload(pcon->p_isc_so->p_library);
+      }
+      mg_free((void *) pcon->p_isc_so, 0);
+   }
+   pcon->p_isc_so = NULL;
+
+   return refs;
+}
+
+
 DBXTHID mg_current_thread_id(void)
 {
 #if defined(_WIN32)
@@ -5798,6 +9103,12 @@ int mg_error_message(DBXMETH *pmeth, int error_code)
 {
    int rc;
 
+   if (error_code == DBX_DEADLINE_EXCEEDED) { /* v1.3.22 */
+      strcpy(pmeth->pcon->error, DBX_DEADLINE_MESSAGE);
+      mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, (char *) DBX_DEADLINE_MESSAGE);
+      return 0;
+   }
+
    if (pmeth->pcon->dbtype == DBX_DBTYPE_YOTTADB) {
       rc = ydb_error_message(pmeth, error_code);
    }
@@ -5844,6 +9155,11 @@ int mg_cleanup(DBXMETH *pmeth)
    int n;
    DBXCON *pcon = pmeth->pcon;
 
+   /* v1.3.22: requests replayed from the write-behind buffer are made within another request, so leave its arena alone */
+   if (pmeth == (DBXMETH *) pcon->pmeth_base) {
+      mg_arena_reset(pcon);
+   }
+
    if (pcon->connected == 2) {
       return 0;
    }
@@ -5863,21 +9179,947 @@ int mg_cleanup(DBXMETH *pmeth)
 }
 
 
-int mg_mutex_create(DBXMUTEX *p_mutex)
+/* v1.3.22: the first part of the cache keys for the nodes read through a connection: the DB Server, or the installation, used */
+int mg_cache_server(DBXCON *pcon, unsigned char *key, int key_size)
 {
-   int result;
+   int klen;
+   char server[320];
 
-   result = 0;
-   if (p_mutex->created) {
-      return result;
+   if (pcon->connected == 2) {
+      sprintf(server, "%s:%d", pcon->ip_address, pcon->port);
+   }
+   else {
+      sprintf(server, "%d:%s", (int) pcon->dbtype, pcon->shdir);
    }
+   klen = (int) strlen(server);
+   if ((klen + 4) > key_size) {
+      return 0;
+   }
+   mg_set_size(key, (unsigned long) klen);
+   memcpy((void *) (key + 4), (void *) server, (size_t) klen);
 
-#if defined(_WIN32)
-   p_mutex->h_mutex = CreateMutex(NULL, FALSE, NULL);
-   result = 0;
-#else
-   result = pthread_mutex_init(&(p_mutex->h_mutex), NULL);
-#endif
+   return (klen + 4);
+}
+
+
+/* v1.3.22: record the namespace a connection is now in, or NULL if it is no longer known
+   The nodes cached through the connection in the namespace it leaves are discarded */
+int mg_namespace_set(DBXCON *pcon, char *nspace)
+{
+   int klen, len;
+   char unspace[72];
+   unsigned char key[512];
+
+   *unspace = '\0';
+   if (nspace && strlen(nspace) < sizeof(unspace)) {
+      strcpy(unspace, nspace);
+      mg_ucase(unspace);
+   }
+   if (!pcon->cur_nspace[0] || !strcmp(unspace, pcon->cur_nspace)) {
+      strcpy(pcon->cur_nspace, unspace);
+      return 0;
+   }
+
+   klen = mg_cache_server(pcon, key, sizeof(key));
+   len = (int) strlen(pcon->cur_nspace);
+   if (klen && (klen + len + 4) <= (int) sizeof(key)) {
+      mg_set_size(key + klen, (unsigned long) len);
+      memcpy((void *) (key + klen + 4), (void *) pcon->cur_nspace, (size_t) len);
+      klen += (len + 4);
+      mg_enter_critical_section((void *) &dbx_global_mutex);
+      mg_cache_invalidate(key, klen, 1);
+      mg_leave_critical_section((void *) &dbx_global_mutex);
+   }
+   strcpy(pcon->cur_nspace, unspace);
+
+   return 1;
+}
+
+
+/* v1.3.19 */
+int mg_cache_key(DBXMETH *pmeth, unsigned char *key, int key_size, int exclude, int *ttl)
+{
+   int n, len, klen, argc, nkeys, offset, dsort, dtype;
+   char *p, *nspace;
+   DBXCON *pcon = pmeth->pcon;
+
+   *ttl = 0;
+   argc = 0;
+   offset = pmeth->offset;
+   for (;;) {
+      len = (int) mg_get_block_size(&(pmeth->input_str), offset, &dsort, &dtype);
+      offset += 5;
+      if (dsort == DBX_DSORT_EOD || dsort == DBX_DSORT_INVALID) {
+         break;
+      }
+      offset += len;
+      argc ++;
+      if (argc > (DBX_MAXARGS - 1)) {
+         break;
+      }
+   }
+
+   if (exclude < 0) { /* global name only */
+      nkeys = 1;
+   }
+   else {
+      nkeys = argc - exclude;
+   }
+   if (nkeys < 1 || argc < 1) {
+      return 0;
+   }
+
+   offset = pmeth->offset;
+   len = (int) mg_get_block_size(&(pmeth->input_str), offset, &dsort, &dtype);
+   p = pmeth->input_str.buf_addr + offset + 5;
+   if (len > 0 && p[0] == '^') {
+      p ++;
+      len --;
+   }
+
+   mg_enter_critical_section((void *) &dbx_global_mutex);
+   for (n = 0; n < dbx_cache.globals; n ++) {
+      if (dbx_cache.global[n].name_len == len && !strncmp(dbx_cache.global[n].name, p, len)) {
+         *ttl = dbx_cache.global[n].ttl;
+         break;
+      }
+   }
+   mg_leave_critical_section((void *) &dbx_global_mutex);
+
+   if (*ttl == 0) {
+      return 0;
+   }
+
+   /* key: server, namespace, global and subscripts, each prefixed by its length */
+   klen = mg_cache_server(pcon, key, key_size);
+   if (!klen) {
+      return 0;
+   }
+   if (pcon->dbtype == DBX_DBTYPE_YOTTADB || pcon->dbtype == DBX_DBTYPE_GTM) {
+      nspace = (char *) "";
+   }
+   else if (pcon->cur_nspace[0]) {
+      nspace = pcon->cur_nspace;
+   }
+   else { /* v1.3.22: the namespace is not known - return the key for everything cached for the server */
+      *ttl = -1;
+      return klen;
+   }
+   len = (int) strlen(nspace);
+   if ((klen + len + 4) > key_size) {
+      return 0;
+   }
+   mg_set_size(key + klen, (unsigned long) len);
+   memcpy((void *) (key + klen + 4), (void *) nspace, (size_t) len);
+   klen += (len + 4);
+
+   for (n = 0; n < nkeys; n ++) {
+      if (n > 0) {
+         len = (int) mg_get_block_size(&(pmeth->input_str), offset, &dsort, &dtype);
+         p = pmeth->input_str.buf_addr + offset + 5;
+      }
+      if ((klen + len + 4) > key_size) {
+         return 0;
+      }
+      mg_set_size(key + klen, (unsigned long) len);
+      memcpy((void *) (key + klen + 4), (void *) p, (size_t) len);
+      klen += (len + 4);
+      offset += (int) (mg_get_block_size(&(pmeth->input_str), offset, &dsort, &dtype) + 5);
+   }
+
+   return klen;
+}
+
+
+int mg_cache_get(DBXMETH *pmeth, unsigned char *key, int key_len, unsigned long long *generation)
+{
+   int result;
+   unsigned long hash;
+   unsigned long long now;
+   DBXCENT *pent;
+
+   result = 0;
+   now = mg_time_ms();
+   hash = mg_cache_hash(key, key_len);
+
+   mg_enter_critical_section((void *) &dbx_global_mutex);
+
+   for (pent = dbx_cache.table[hash % DBX_CACHE_HASHSIZE]; pent; pent = pent->pnext) {
+      if (pent->hash == hash && pent->key_len == key_len && !memcmp((void *) pent->key, (void *) key, (size_t) key_len)) {
+         break;
+      }
+   }
+   if (pent && pent->expiry <= now) {
+      mg_cache_remove(pent);
+      pent = NULL;
+   }
+
+   if (pent && (unsigned int) (pent->data_len + 7) <= pmeth->output_val.svalue.len_alloc) {
+      memcpy((void *) (pmeth->output_val.svalue.buf_addr + 5), (void *) pent->data, (size_t) pent->data_len);
+      pmeth->output_val.svalue.len_used = pent->data_len + 5;
+      mg_add_block_size(&(pmeth->output_val.svalue), 0, (unsigned long) pent->data_len, DBX_DSORT_DATA, DBX_DTYPE_DBXSTR);
+
+      if (pent != dbx_cache.plru_head) { /* most recently used to the front */
+         pent->plru_prev->plru_next = pent->plru_next;
+         if (pent->plru_next)
+            pent->plru_next->plru_prev = pent->plru_prev;
+         else
+            dbx_cache.plru_tail = pent->plru_prev;
+         pent->plru_prev = NULL;
+         pent->plru_next = dbx_cache.plru_head;
+         dbx_cache.plru_head->plru_prev = pent;
+         dbx_cache.plru_head = pent;
+      }
+      dbx_cache.hits ++;
+      result = 1;
+   }
+   else {
+      dbx_cache.misses ++;
+      *generation = dbx_cache.generation; /* the value read from the database may be cached unless invalidated in the meantime */
+   }
+
+   mg_leave_critical_section((void *) &dbx_global_mutex);
+
+   return result;
+}
+
+
+int mg_cache_put(unsigned char *key, int key_len, int ttl, unsigned char *data, int data_len, unsigned long long generation)
+{
+   unsigned long hash, size;
+   unsigned long long now;
+   DBXCENT *pent;
+
+   size = (unsigned long) (key_len + data_len);
+   now = mg_time_ms();
+   hash = mg_cache_hash(key, key_len);
+
+   mg_enter_critical_section((void *) &dbx_global_mutex);
+
+   if (size > dbx_cache.max_size || generation != dbx_cache.generation) { /* too big, or cached nodes invalidated since the read */
+      mg_leave_critical_section((void *) &dbx_global_mutex);
+      return 0;
+   }
+
+   mg_cache_invalidate(key, key_len, 0);
+   while (dbx_cache.plru_tail && (dbx_cache.entries >= dbx_cache.max_entries || (dbx_cache.size + size) > dbx_cache.max_size)) {
+      mg_cache_remove(dbx_cache.plru_tail);
+   }
+
+   pent = (DBXCENT *) mg_malloc(sizeof(DBXCENT) + size, 0);
+   if (pent) {
+      pent->hash = hash;
+      pent->expiry = now + ttl;
+      pent->key_len = key_len;
+      pent->data_len = data_len;
+      pent->key = ((unsigned char *) pent) + sizeof(DBXCENT);
+      pent->data = pent->key + key_len;
+      memcpy((void *) pent->key, (void *) key, (size_t) key_len);
+      memcpy((void *) pent->data, (void *) data, (size_t) data_len);
+
+      pent->pnext = dbx_cache.table[hash % DBX_CACHE_HASHSIZE];
+      dbx_cache.table[hash % DBX_CACHE_HASHSIZE] = pent;
+
+      pent->plru_prev = NULL;
+      pent->plru_next = dbx_cache.plru_head;
+      if (dbx_cache.plru_head)
+         dbx_cache.plru_head->plru_prev = pent;
+      else
+         dbx_cache.plru_tail = pent;
+      dbx_cache.plru_head = pent;
+
+      dbx_cache.entries ++;
+      dbx_cache.size += size;
+   }
+
+   mg_leave_critical_section((void *) &dbx_global_mutex);
+
+   return (pent ? 1 : 0);
+}
+
+
+/*
+   Context: 0 - the node specified
+            1 - the node specified and all its descendants
+            2 - everything
+   The caller must hold dbx_global_mutex.
+*/
+
+int mg_cache_invalidate(unsigned char *key, int key_len, int context)
+{
+   int result;
+   unsigned long hash;
+   DBXCENT *pent, *pnext;
+
+   result = 0;
+   dbx_cache.generation ++;
+   if (context == 0) {
+      hash = mg_cache_hash(key, key_len);
+      for (pent = dbx_cache.table[hash % DBX_CACHE_HASHSIZE]; pent; pent = pent->pnext) {
+         if (pent->hash == hash && pent->key_len == key_len && !memcmp((void *) pent->key, (void *) key, (size_t) key_len)) {
+            mg_cache_remove(pent);
+            result ++;
+            break;
+         }
+      }
+      return result;
+   }
+
+   for (pent = dbx_cache.plru_head; pent; pent = pnext) {
+      pnext = pent->plru_next;
+      if (context == 2 || (pent->key_len >= key_len && !memcmp((void *) pent->key, (void *) key, (size_t) key_len))) {
+         mg_cache_remove(pent);
+         result ++;
+      }
+   }
+
+   return result;
+}
+
+
+int mg_cache_remove(DBXCENT *pent)
+{
+   DBXCENT **ppent;
+
+   for (ppent = &(dbx_cache.table[pent->hash % DBX_CACHE_HASHSIZE]); *ppent; ppent = &((*ppent)->pnext)) {
+      if (*ppent == pent) {
+         *ppent = pent->pnext;
+         break;
+      }
+   }
+
+   if (pent->plru_prev)
+      pent->plru_prev->plru_next = pent->plru_next;
+   else
+      dbx_cache.plru_head = pent->plru_next;
+   if (pent->plru_next)
+      pent->plru_next->plru_prev = pent->plru_prev;
+   else
+      dbx_cache.plru_tail = pent->plru_prev;
+
+   dbx_cache.entries --;
+   dbx_cache.size -= (unsigned long) (pent->key_len + pent->data_len);
+
+   mg_free((void *) pent, 0);
+
+   return 0;
+}
+
+
+unsigned long mg_cache_hash(unsigned char *key, int key_len)
+{
+   int n;
+   unsigned long hash;
+
+   hash = 2166136261UL; /* FNV-1a */
+   for (n = 0; n < key_len; n ++) {
+      hash ^= (unsigned long) key[n];
+      hash *= 16777619UL;
+      hash &= 0xffffffffUL;
+   }
+
+   return hash;
+}
+
+
+unsigned long long mg_time_ms(void)
+{
+#if defined(_WIN32)
+   return (unsigned long long) GetTickCount64();
+#else
+   struct timeval tv;
+
+   gettimeofday(&tv, NULL);
+   return ((unsigned long long) tv.tv_sec * 1000) + (unsigned long long) (tv.tv_usec / 1000);
+#endif
+}
+
+
+/* v1.3.22: find the nodes in a list of locks: returns the number of nodes */
+int mg_lock_list(DBXMETH *pmeth, int *nodes, int *nsubs, int max)
+{
+   int n, nnodes;
+
+   nnodes = 0;
+   for (n = 0; n < pmeth->argc; n ++) {
+      pmeth->yargs[n].len_alloc = pmeth->args[n].svalue.len_used;
+      pmeth->yargs[n].len_used = pmeth->args[n].svalue.len_used;
+      pmeth->yargs[n].buf_addr = (char *) pmeth->args[n].svalue.buf_addr;
+
+      if (pmeth->args[n].sort == DBX_DSORT_GLOBAL) {
+         if (nnodes == max) {
+            break;
+         }
+         nodes[nnodes] = n;
+         nsubs[nnodes] = 0;
+         nnodes ++;
+      }
+      else if (pmeth->args[n].sort == DBX_DSORT_SUBSCRIPT && nnodes > 0) {
+         nsubs[nnodes - 1] ++;
+      }
+   }
+
+   return nnodes;
+}
+
+
+/* v1.3.22: lock or unlock one node from a list of locks */
+int mg_lock_node(DBXMETH *pmeth, int node, int nsubs, int lock, int timeout, int *retval)
+{
+   int rc, n, len, dsort, dtype, limited;
+   unsigned long long timeout_nsec, timeout_ms;
+   char buffer[32];
+   DBXSTR input, input_save;
+   DBXCON *pcon = pmeth->pcon;
+
+   *retval = 0;
+
+   limited = 0;
+   timeout_ms = 0;
+   if (lock) { /* v1.3.22: wait no longer than the request's deadline allows */
+      limited = mg_lock_timeout(pcon, timeout, &timeout_ms);
+      if (limited) {
+         timeout = (int) ((timeout_ms + 999) / 1000); /* round up: the deadline decides whether the wait ends early */
+      }
+   }
+
+   if (pcon->connected == 2) { /* send the node as a request for dbx_lock() or dbx_unlock() */
+      char *p;
+
+      p = pmeth->args[node].svalue.buf_addr - 5;
+      len = (int) ((pmeth->args[node + nsubs].svalue.buf_addr + pmeth->args[node + nsubs].svalue.len_used) - p);
+
+      input.len_alloc = 15 + len + 32;
+      input.buf_addr = (char *) mg_arena_alloc(pcon, sizeof(char) * input.len_alloc); /* v1.3.22 */
+      if (!input.buf_addr) {
+         mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, "Unable to allocate memory for the lock request");
+         return CACHE_FAILURE;
+      }
+      memcpy((void *) input.buf_addr, (void *) pmeth->input_str.buf_addr, 15);
+      memcpy((void *) (input.buf_addr + 15), (void *) p, len);
+      input.len_used = 15 + len;
+      if (lock) {
+         sprintf(buffer, "%d", timeout);
+         n = (int) strlen(buffer);
+         mg_add_block_size(&input, input.len_used, n, DBX_DSORT_DATA, DBX_DTYPE_STR);
+         memcpy((void *) (input.buf_addr + input.len_used + 5), (void *) buffer, n);
+         input.len_used += (5 + n);
+      }
+      mg_add_block_size(&input, input.len_used, 0, DBX_DSORT_EOD, DBX_DTYPE_STR);
+      input.len_used += 5;
+      mg_add_block_head_size(&input, input.len_used, lock ? DBX_CMND_GLOCK : DBX_CMND_GUNLOCK);
+
+      input_save = pmeth->input_str;
+      pmeth->input_str = input;
+      rc = netx_tcp_command(pmeth, 0);
+      pmeth->input_str = input_save;
+
+      if (rc == CACHE_SUCCESS) {
+         len = (int) mg_get_block_size(&(pmeth->output_val.svalue), 0, &dsort, &dtype);
+         if (dsort == DBX_DSORT_ERROR) {
+            rc = CACHE_FAILURE;
+         }
+         else {
+            *retval = (len > 0 && pmeth->output_val.svalue.buf_addr[5] == '1');
+            if (!(*retval) && limited) {
+               rc = DBX_DEADLINE_EXCEEDED;
+            }
+         }
+      }
+      return rc;
+   }
+
+   if (pcon->dbtype == DBX_DBTYPE_YOTTADB) {
+      if (lock) {
+         timeout_nsec = timeout_ms * 1000000;
+         rc = pcon->p_ydb_so->p_ydb_lock_incr_s(timeout_nsec, &(pmeth->yargs[node]), nsubs, &(pmeth->yargs[node + 1]));
+      }
+      else {
+         rc = pcon->p_ydb_so->p_ydb_lock_decr_s(&(pmeth->yargs[node]), nsubs, &(pmeth->yargs[node + 1]));
+      }
+      if (rc == YDB_OK) {
+         *retval = 1;
+      }
+      else if (rc == YDB_LOCK_TIMEOUT) {
+         rc = limited ? DBX_DEADLINE_EXCEEDED : YDB_OK;
+      }
+      else {
+         rc = CACHE_FAILURE;
+      }
+      return rc;
+   }
+
+   rc = pcon->p_isc_so->p_CachePushLock((int) pmeth->args[node].svalue.len_used, (Callin_char_t *) pmeth->args[node].svalue.buf_addr);
+   for (n = 1; rc == CACHE_SUCCESS && n <= nsubs; n ++) {
+      if (pmeth->args[node + n].svalue.len_used >= DBX_MAXSIZE) {
+         rc = CACHE_FAILURE;
+         break;
+      }
+      rc = pcon->p_isc_so->p_CachePushStr(pmeth->args[node + n].svalue.len_used, (Callin_char_t *) pmeth->args[node + n].svalue.buf_addr);
+   }
+   if (rc != CACHE_SUCCESS) {
+      return rc;
+   }
+   if (lock) {
+      rc = pcon->p_isc_so->p_CacheAcquireLock(nsubs, CACHE_INCREMENTAL_LOCK, timeout, retval);
+      if (rc == CACHE_SUCCESS && !(*retval) && limited) {
+         rc = DBX_DEADLINE_EXCEEDED;
+      }
+   }
+   else {
+      rc = pcon->p_isc_so->p_CacheReleaseLock(nsubs, CACHE_INCREMENTAL_LOCK);
+      *retval = (rc == CACHE_SUCCESS);
+   }
+
+   return rc;
+}
+
+
+/* v1.3.22: record 'nlocks' locks acquired (or, if negative, released) and the time spent waiting */
+int mg_lock_stat(DBXCON *pcon, int nlocks, unsigned long long wait_start, int timed_out)
+{
+   unsigned long long now, elapsed;
+   DBXLSTAT *pstat;
+
+   pstat = &(pcon->lstat);
+   now = mg_time_ms();
+
+   if (nlocks > 0 || timed_out) {
+      elapsed = (now > wait_start) ? (now - wait_start) : 0;
+      pstat->wait_ms += elapsed;
+      if (elapsed > pstat->wait_max) {
+         pstat->wait_max = elapsed;
+      }
+      if (timed_out) {
+         pstat->timeouts ++;
+      }
+   }
+
+   if (nlocks > 0) {
+      pstat->locks += nlocks;
+      if (pstat->held == 0) {
+         pstat->hold_start = now;
+      }
+      pstat->held += nlocks;
+   }
+   else if (nlocks < 0 && pstat->held > 0) {
+      pstat->held += nlocks;
+      if (pstat->held <= 0) {
+         pstat->held = 0;
+         elapsed = (now > pstat->hold_start) ? (now - pstat->hold_start) : 0;
+         pstat->holds ++;
+         pstat->hold_ms += elapsed;
+         if (elapsed > pstat->hold_max) {
+            pstat->hold_max = elapsed;
+         }
+      }
+   }
+
+   return 0;
+}
+
+
+/* v1.3.22: hash the global name and subscripts of a node to be locked, without the '^' that may have been added to the name */
+unsigned long mg_lock_hash(DBXMETH *pmeth, int node, int nsubs)
+{
+   int n, len;
+   unsigned long hash;
+   unsigned char *p;
+
+   hash = 2166136261UL; /* FNV-1a */
+   for (n = node; n <= (node + nsubs) && n < pmeth->argc; n ++) {
+      p = (unsigned char *) pmeth->args[n].svalue.buf_addr;
+      len = (int) pmeth->args[n].svalue.len_used;
+      if (n == node && len > 0 && p[0] == '^') {
+         p ++;
+         len --;
+      }
+      for (; len > 0; len --, p ++) {
+         hash ^= (unsigned long) *p;
+         hash *= 16777619UL;
+         hash &= 0xffffffffUL;
+      }
+      hash ^= 0xffUL; /* separator */
+      hash *= 16777619UL;
+      hash &= 0xffffffffUL;
+   }
+
+   return hash;
+}
+
+
+/* v1.3.22: record a node locked (or, if 'lock' is zero, released) through a connection
+   Returns 1 if the lock is counted: a release counts only if the node was locked through this connection
+*/
+int mg_lock_held(DBXCON *pcon, unsigned long hash, int lock)
+{
+   int n;
+   DBXLNODE *p_nodes;
+   DBXLSTAT *pstat;
+
+   pstat = &(pcon->lstat);
+   for (n = 0; n < pstat->nnodes; n ++) {
+      if (pstat->p_nodes[n].hash == hash) {
+         break;
+      }
+   }
+
+   if (!lock) {
+      if (n == pstat->nnodes) {
+         return 0;
+      }
+      if (-- pstat->p_nodes[n].count == 0) {
+         pstat->p_nodes[n] = pstat->p_nodes[-- pstat->nnodes];
+      }
+      return 1;
+   }
+
+   if (n < pstat->nnodes) {
+      pstat->p_nodes[n].count ++;
+      return 1;
+   }
+   if (pstat->nnodes == pstat->max_nodes) {
+      p_nodes = (DBXLNODE *) mg_malloc(sizeof(DBXLNODE) * (pstat->max_nodes + 32), 0);
+      if (!p_nodes) {
+         return 1;
+      }
+      if (pstat->p_nodes) {
+         memcpy((void *) p_nodes, (void *) pstat->p_nodes, sizeof(DBXLNODE) * pstat->nnodes);
+         mg_free((void *) pstat->p_nodes, 0);
+      }
+      pstat->p_nodes = p_nodes;
+      pstat->max_nodes += 32;
+   }
+   pstat->p_nodes[pstat->nnodes].hash = hash;
+   pstat->p_nodes[pstat->nnodes].count = 1;
+   pstat->nnodes ++;
+
+   return 1;
+}
+
+
+int mg_lock_free(DBXCON *pcon)
+{
+   DBXLSTAT *pstat;
+
+   pstat = &(pcon->lstat);
+   if (pstat->p_nodes) {
+      mg_free((void *) pstat->p_nodes, 0);
+   }
+   memset((void *) pstat, 0, sizeof(DBXLSTAT));
+
+   return 0;
+}
+
+
+/* v1.3.22: the time (ms) to wait for a lock given its timeout (seconds, or negative for none): returns 1 if the wait is cut short by the request's deadline */
+int mg_lock_timeout(DBXCON *pcon, int timeout, unsigned long long *timeout_ms)
+{
+   int remaining;
+
+   *timeout_ms = (timeout < 0) ? 3600000 : ((unsigned long long) timeout * 1000);
+
+   remaining = mg_deadline_ms(pcon);
+   if (remaining >= 0 && (unsigned long long) remaining < *timeout_ms) {
+      *timeout_ms = (unsigned long long) remaining;
+      return 1;
+   }
+
+   return 0;
+}
+
+
+/* v1.3.22: the time (ms) left before the deadline for the current request: -1 if there is no deadline */
+int mg_deadline_ms(DBXCON *pcon)
+{
+   unsigned long long deadline, now;
+
+   deadline = pcon->deadline;
+   if (!deadline) {
+      return -1;
+   }
+
+   now = mg_time_ms();
+   if (now >= deadline) {
+      return 0;
+   }
+   if ((deadline - now) > 0x7fffffff) {
+      return 0x7fffffff;
+   }
+
+   return (int) (deadline - now);
+}
+
+
+/* v1.3.20 */
+int mg_wbuf_add(DBXMETH *pmeth)
+{
+   int len, argc, offset, key_len, dsort, dtype;
+   unsigned long hash;
+   unsigned char *key, *req;
+   DBXWENT *pent;
+   DBXCON *pcon = pmeth->pcon;
+   DBXWBUF *pwbuf = (DBXWBUF *) pcon->p_wbuf;
+
+   /* The node is identified by everything in the request up to the (last) data argument */
+   argc = 0;
+   key_len = 0;
+   offset = pmeth->offset;
+   for (;;) {
+      len = (int) mg_get_block_size(&(pmeth->input_str), offset, &dsort, &dtype);
+      if (dsort == DBX_DSORT_EOD || dsort == DBX_DSORT_INVALID) {
+         break;
+      }
+      key_len = (offset - pmeth->offset);
+      offset += (5 + len);
+      argc ++;
+      if (argc > (DBX_MAXARGS - 1)) {
+         return -1;
+      }
+   }
+   if (argc < 2) {
+      return -1;
+   }
+
+   key = (unsigned char *) pmeth->input_str.buf_addr + pmeth->offset;
+   hash = mg_cache_hash(key, key_len);
+
+   for (pent = pwbuf->table[hash % DBX_WBUF_HASHSIZE]; pent; pent = pent->pnext) {
+      if (pent->hash == hash && pent->key_len == key_len && pent->offset == pmeth->offset && !memcmp((void *) (pent->req + pent->offset), (void *) key, key_len)) {
+         break;
+      }
+   }
+
+   req = (unsigned char *) mg_malloc(sizeof(char) * pmeth->input_str.len_used, 0);
+   if (!req) {
+      mg_wbuf_flush(pcon);
+      return -1;
+   }
+   memcpy((void *) req, (void *) pmeth->input_str.buf_addr, pmeth->input_str.len_used);
+
+   if (pent) { /* coalesce: the latest value replaces the one held for this node, which keeps its place in the queue */
+      pwbuf->size -= (unsigned long) pent->req_len;
+      mg_free((void *) pent->req, 0);
+   }
+   else {
+      pent = (DBXWENT *) mg_malloc(sizeof(DBXWENT), 0);
+      if (!pent) {
+         mg_free((void *) req, 0);
+         mg_wbuf_flush(pcon);
+         return -1;
+      }
+      pent->hash = hash;
+      pent->offset = pmeth->offset;
+      pent->key_len = key_len;
+      pent->pnext = pwbuf->table[hash % DBX_WBUF_HASHSIZE];
+      pwbuf->table[hash % DBX_WBUF_HASHSIZE] = pent;
+      pent->plist_next = NULL;
+      if (pwbuf->plist_tail)
+         pwbuf->plist_tail->plist_next = pent;
+      else
+         pwbuf->plist_head = pent;
+      pwbuf->plist_tail = pent;
+      if (pwbuf->entries == 0) {
+         pwbuf->first = mg_time_ms();
+      }
+      pwbuf->entries ++;
+   }
+
+   pent->req = req;
+   pent->req_len = pmeth->input_str.len_used;
+   pwbuf->size += (unsigned long) pent->req_len;
+   pwbuf->sets ++;
+
+   if (pwbuf->entries >= pwbuf->max_entries || pwbuf->size >= pwbuf->max_size || (pwbuf->max_age > 0 && (mg_time_ms() - pwbuf->first) >= (unsigned long long) pwbuf->max_age)) {
+      mg_wbuf_flush(pcon);
+   }
+
+   return CACHE_SUCCESS;
+}
+
+
+int mg_wbuf_flush(DBXCON *pcon)
+{
+   int rc, result, len, get, total, dsort;
+   unsigned char *p;
+   DBXWENT *pent;
+   DBXMETH *pmeth;
+   DBXWBUF *pwbuf = (DBXWBUF *) pcon->p_wbuf;
+
+   if (!pwbuf || !pwbuf->entries) {
+      return CACHE_SUCCESS;
+   }
+
+   result = CACHE_SUCCESS;
+
+   if (pcon->connected == 2 && !pcon->p_srv) {
+      /* Pipeline the buffered requests: send them all in one write then collect the responses in order */
+      p = (unsigned char *) mg_arena_alloc(pcon, sizeof(char) * pwbuf->size); /* v1.3.22 */
+      if (p) {
+         len = 0;
+         for (pent = pwbuf->plist_head; pent; pent = pent->plist_next) {
+            memcpy((void *) (p + len), (void *) pent->req, pent->req_len);
+            len += pent->req_len;
+         }
+         rc = netx_tcp_write(pcon, p, len);
+         if (rc < 0 && pcon->p_stby && !((DBXSTBY *) pcon->p_stby)->tlevel && netx_tcp_failover(pcon)) {
+            /* v1.3.22: nothing was written, so the requests can be sent over a standby connection */
+            rc = netx_tcp_write(pcon, p, len);
+         }
+         pwbuf->writes ++;
+
+         for (pent = pwbuf->plist_head; pent && rc >= 0; pent = pent->plist_next) {
+            rc = netx_tcp_read(pcon, pwbuf->output, 5, pcon->timeout, 1);
+            if (rc != 5) {
+               break;
+            }
+            len = (int) mg_get_size(pwbuf->output);
+            dsort = pwbuf->output[4] / 20;
+            for (total = 0; total < len; total += get) {
+               get = (len - total);
+               if (get > (DBX_WBUF_OUTPUT - 6))
+                  get = (DBX_WBUF_OUTPUT - 6);
+               rc = netx_tcp_read(pcon, pwbuf->output + 5, get, pcon->timeout, 1);
+               if (rc != get) {
+                  break;
+               }
+               if (total == 0 && dsort == DBX_DSORT_ERROR) {
+                  result = CACHE_FAILURE;
+                  if (!pwbuf->error[0]) {
+                     get = (get < (DBX_ERROR_SIZE - 1)) ? get : (DBX_ERROR_SIZE - 1);
+                     strncpy(pwbuf->error, (char *) pwbuf->output + 5, get);
+                     pwbuf->error[get] = '\0';
+                  }
+               }
+            }
+            if (total < len) {
+               rc = -1;
+               break;
+            }
+         }
+         if (rc < 0 || (pent && rc != 5)) {
+            /* the responses still to come can't be matched to their requests: the connection can't be used again */
+            pcon->eof = 1;
+            if (!pwbuf->error[0]) {
+               strcpy(pwbuf->error, "Lost connection while writing buffered data");
+            }
+            result = CACHE_FAILURE;
+         }
+         mg_wbuf_clear(pwbuf);
+         return result;
+      }
+   }
+
+   pmeth = &(pwbuf->meth);
+   pmeth->pcon = pcon;
+
+   for (pent = pwbuf->plist_head; pent; pent = pent->plist_next) {
+      pmeth->argc = 0;
+      pmeth->input_str.buf_addr = (char *) pent->req;
+      pmeth->input_str.len_used = pent->req_len;
+      pmeth->offset = pent->offset;
+      pmeth->output_val.realloc = 0;
+      pmeth->output_val.svalue.buf_addr = (char *) pwbuf->output;
+      pmeth->output_val.svalue.len_alloc = DBX_WBUF_OUTPUT;
+      pmeth->output_val.offset = 5;
+      pmeth->output_val.svalue.len_used = 5;
+
+      if (pcon->connected == 2) {
+         strcpy(pmeth->command, "S");
+         rc = netx_tcp_command(pmeth, 0);
+         if (rc == CACHE_SUCCESS && (pwbuf->output[4] / 20) == DBX_DSORT_ERROR) {
+            rc = CACHE_FAILURE;
+            if (!pwbuf->error[0]) {
+               strncpy(pwbuf->error, (char *) pwbuf->output + 5, DBX_ERROR_SIZE - 1);
+               pwbuf->error[DBX_ERROR_SIZE - 1] = '\0';
+            }
+         }
+      }
+      else {
+         pmeth->increment = 0;
+         pmeth->merge = 0;
+         pmeth->lock = 0;
+         pmeth->query = 0;
+         rc = mg_global_reference(pmeth);
+
+         if (rc == CACHE_SUCCESS) {
+            if (pcon->dbtype == DBX_DBTYPE_YOTTADB && pcon->tlevel > 0) {
+               pmeth->p_dbxfun = (int (*) (struct tagDBXMETH * pmeth)) dbx_set_ex;
+               rc = ydb_transaction_task(pmeth, YDB_TPCTX_DB);
+            }
+            else {
+               rc = dbx_set_ex(pmeth);
+            }
+         }
+         if (rc != CACHE_SUCCESS) {
+            pmeth->output_val.svalue.len_used = 5;
+            mg_error_message(pmeth, rc);
+            if (!pwbuf->error[0]) {
+               strcpy(pwbuf->error, pcon->error);
+            }
+         }
+         mg_cleanup(pmeth);
+      }
+
+      pwbuf->writes ++;
+      if (rc != CACHE_SUCCESS) {
+         result = rc;
+      }
+   }
+
+   mg_wbuf_clear(pwbuf);
+
+   return result;
+}
+
+
+/* v1.3.20: report (and clear) the failure of a buffered Set */
+int mg_wbuf_error(DBXMETH *pmeth)
+{
+   DBXWBUF *pwbuf = (DBXWBUF *) pmeth->pcon->p_wbuf;
+
+   mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, pwbuf->error[0] ? pwbuf->error : (char *) "Unable to write buffered data");
+   pwbuf->error[0] = '\0';
+
+   return 0;
+}
+
+
+int mg_wbuf_clear(DBXWBUF *pwbuf)
+{
+   DBXWENT *pent, *pnext;
+
+   for (pent = pwbuf->plist_head; pent; pent = pnext) {
+      pnext = pent->plist_next;
+      mg_free((void *) pent->req, 0);
+      mg_free((void *) pent, 0);
+   }
+
+   memset((void *) pwbuf->table, 0, sizeof(pwbuf->table));
+   pwbuf->plist_head = NULL;
+   pwbuf->plist_tail = NULL;
+   pwbuf->entries = 0;
+   pwbuf->size = 0;
+
+   return 0;
+}
+
+
+int mg_mutex_create(DBXMUTEX *p_mutex)
+{
+   int result;
+
+   result = 0;
+   if (p_mutex->created) {
+      return result;
+   }
+
+#if defined(_WIN32)
+   p_mutex->h_mutex = CreateMutex(NULL, FALSE, NULL);
+   result = 0;
+#else
+   result = pthread_mutex_init(&(p_mutex->h_mutex), NULL);
+#endif
 
    p_mutex->created = 1;
    p_mutex->stack = 0;
@@ -5932,18 +10174,70 @@ int mg_mutex_lock(DBXMUTEX *p_mutex, int timeout)
       printf("\r\nmg_mutex_lock: Returned WAIT_FAILED state: Error Code: %d", GetLastError());
       result = -1;
    }
-   else {
-      printf("\r\nmg_mutex_lock: Returned Unrecognized state: %d", result_wait);
-      result = -1;
+   else {
+      printf("\r\nmg_mutex_lock: Returned Unrecognized state: %d", result_wait);
+      result = -1;
+   }
+#else
+   result = pthread_mutex_lock(&(p_mutex->h_mutex));
+#endif
+
+   p_mutex->thid = tid;
+   p_mutex->stack = 0;
+
+   return result;
+}
+
+
+/* v1.3.22: lock a mutex, giving up if the deadline for the connection's current request passes first */
+int mg_mutex_lock_deadline(DBXMUTEX *p_mutex, DBXCON *pcon)
+{
+   int result;
+   DBXTHID tid;
+#ifdef _WIN32
+   DWORD result_wait;
+#endif
+
+   result = 0;
+
+   if (!p_mutex->created) {
+      return -1;
+   }
+
+   tid = mg_current_thread_id();
+   if (p_mutex->thid == tid) {
+      p_mutex->stack ++;
+      return 0; /* success - thread already owns lock */
    }
+
+   for (;;) {
+      if (mg_deadline_ms(pcon) == 0) {
+         return DBX_DEADLINE_EXCEEDED;
+      }
+#if defined(_WIN32)
+      result_wait = WaitForSingleObject(p_mutex->h_mutex, DBX_DEADLINE_STEP);
+      if (result_wait == WAIT_OBJECT_0) {
+         break;
+      }
+      if (result_wait != WAIT_TIMEOUT) {
+         return -1;
+      }
 #else
-   result = pthread_mutex_lock(&(p_mutex->h_mutex));
+      result = pthread_mutex_trylock(&(p_mutex->h_mutex));
+      if (result == 0) {
+         break;
+      }
+      if (result != EBUSY) {
+         return result;
+      }
+      mg_sleep(1);
 #endif
+   }
 
    p_mutex->thid = tid;
    p_mutex->stack = 0;
 
-   return result;
+   return 0;
 }
 
 
@@ -6332,7 +10626,7 @@ int netx_tcp_connect(DBXCON *pcon, int context)
    int n, errorno;
    unsigned long inetaddr;
    DWORD spin_count;
-   char ansi_ip_address[64];
+   char ansi_ip_address[128];
    struct sockaddr_in srv_addr, cli_addr;
    struct hostent *hp;
    struct in_addr **pptr;
@@ -6343,6 +10637,10 @@ int netx_tcp_connect(DBXCON *pcon, int context)
    getaddrinfo_ok = 0;
    spin_count = 0;
 
+   if (!strncmp(pcon->ip_address, NETX_UNIX_PREFIX, NETX_UNIX_PREFIX_LEN)) { /* v1.3.22 */
+      return netx_unix_connect(pcon, context);
+   }
+
    ipv6 = 1;
 #if !defined(NETX_IPV6)
    ipv6 = 0;
@@ -6775,8 +11073,22 @@ int netx_tcp_command(DBXMETH *pmeth, int context)
       return mg_db_command(pmeth, context);
    }
 
-   netx_tcp_write(pcon, (unsigned char *) pmeth->input_str.buf_addr, pmeth->input_str.len_used);
-   netx_tcp_read(pcon, (unsigned char *) pmeth->output_val.svalue.buf_addr, 5, pcon->timeout, 1); /* v1.2.8 */
+   if (pcon->p_stby) { /* v1.3.22 */
+      rc = netx_tcp_command_stby(pmeth, context);
+      if (rc != CACHE_SUCCESS) {
+         return rc;
+      }
+   }
+   else {
+      len = netx_tcp_write(pcon, (unsigned char *) pmeth->input_str.buf_addr, pmeth->input_str.len_used);
+      if (len >= 0) {
+         len = netx_tcp_read(pcon, (unsigned char *) pmeth->output_val.svalue.buf_addr, 5, pcon->timeout, 1); /* v1.2.8 */
+      }
+      if (pcon->eof && len != 5) { /* v1.3.22: the request was abandoned at its deadline, or the connection already has been */
+         mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, pcon->error[0] ? pcon->error : (char *) "TCP Read Error: Server closed the connection");
+         return CACHE_NOCON;
+      }
+   }
    pmeth->output_val.svalue.buf_addr[5] = '\0';
 
    len = mg_get_size((unsigned char *) pmeth->output_val.svalue.buf_addr);
@@ -6823,13 +11135,452 @@ int netx_tcp_command(DBXMETH *pmeth, int context)
       mg_add_block_size(&(pmeth->output_val.svalue), 0, (unsigned long) len, DBX_DSORT_DATA, DBX_DTYPE_DBXSTR);
    }
 
-   if (len > 0) {
-      netx_tcp_read(pcon, (unsigned char *) pmeth->output_val.svalue.buf_addr + 5, len, pcon->timeout, 1); /* v1.2.8 */
+   if (len > 0) {
+      if (netx_tcp_read(pcon, (unsigned char *) pmeth->output_val.svalue.buf_addr + 5, len, pcon->timeout, 1) == NETX_READ_DEADLINE) { /* v1.2.8 */
+         mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, pcon->error);
+         return CACHE_NOCON;
+      }
+   }
+
+   pmeth->output_val.svalue.len_used = len;
+
+   return rc;
+}
+
+
+/* v1.3.22: send a request, swapping in a standby connection if the server has gone away */
+int netx_tcp_command_stby(DBXMETH *pmeth, int context)
+{
+   int n, written, attempt, cmnd;
+   char error[DBX_ERROR_SIZE];
+   DBXCON *pcon = pmeth->pcon;
+   DBXSTBY *pstby = (DBXSTBY *) pcon->p_stby;
+
+   cmnd = (int) ((unsigned char) pmeth->input_str.buf_addr[4]);
+   error[0] = '\0';
+   for (attempt = 0; ; attempt ++) {
+      if (pcon->eof && !netx_tcp_failover(pcon)) {
+         strcpy(error, pcon->error);
+         break;
+      }
+      n = netx_tcp_write(pcon, (unsigned char *) pmeth->input_str.buf_addr, pmeth->input_str.len_used);
+      written = (n >= 0);
+      if (written) {
+         n = netx_tcp_read(pcon, (unsigned char *) pmeth->output_val.svalue.buf_addr, 5, pcon->timeout, 1);
+      }
+      if (n == 5) {
+         break;
+      }
+
+      /* The connection can't be used again: replace it before the next request */
+      strcpy(error, pcon->error);
+      pcon->eof = 1;
+      pcon->connected = 2;
+
+      /* Only resend if the server can't have run the request (the write failed) or running it twice does no harm, and not within a transaction */
+      if ((written && !netx_tcp_idempotent(cmnd)) || n == NETX_READ_TIMEOUT || n == NETX_READ_DEADLINE || n > 0 || pstby->tlevel || attempt) {
+         break;
+      }
+   }
+
+   if (n != 5) {
+      pstby->tlevel = 0;
+      mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, error[0] ? error : (char *) "TCP Read Error: Server closed the connection");
+      return CACHE_NOCON;
+   }
+
+   if (cmnd == DBX_CMND_TSTART) {
+      pstby->tlevel ++;
+   }
+   else if (cmnd == DBX_CMND_TCOMMIT && pstby->tlevel > 0) {
+      pstby->tlevel --;
+   }
+   else if (cmnd == DBX_CMND_TROLLBACK) {
+      pstby->tlevel = 0;
+   }
+
+   return CACHE_SUCCESS;
+}
+
+
+/* v1.3.22: requests that only read, and can therefore be sent again if their reply is lost */
+int netx_tcp_idempotent(int cmnd)
+{
+   switch (cmnd) {
+      case DBX_CMND_NSGET:
+      case DBX_CMND_GGET:
+      case DBX_CMND_GNEXT:
+      case DBX_CMND_GNEXTDATA:
+      case DBX_CMND_GPREVIOUS:
+      case DBX_CMND_GPREVIOUSDATA:
+      case DBX_CMND_GDEFINED:
+      case DBX_CMND_GNNODE:
+      case DBX_CMND_GNNODEDATA:
+      case DBX_CMND_GPNODE:
+      case DBX_CMND_GPNODEDATA:
+         return 1;
+      default:
+         return 0;
+   }
+}
+
+
+int netx_tcp_failover(DBXCON *pcon)
+{
+   int n, got;
+   SOCKET sock;
+   DBXSTBY *pstby, stby;
+   fd_set rset;
+   struct timeval tval;
+   char error[DBX_ERROR_SIZE];
+
+   pstby = (DBXSTBY *) pcon->p_stby;
+   if (!pstby) {
+      return 0;
+   }
+
+   got = 0;
+   sock = (SOCKET) 0;
+   for (;;) {
+      mg_enter_critical_section((void *) &dbx_global_mutex);
+      if (pstby->count > 0) {
+         sock = pstby->socket[0];
+         pstby->count --;
+         for (n = 0; n < pstby->count; n ++) {
+            pstby->socket[n] = pstby->socket[n + 1];
+         }
+         got = 1;
+      }
+      else {
+         memcpy((void *) &stby, (void *) pstby, sizeof(DBXSTBY));
+         got = 0;
+      }
+      mg_leave_critical_section((void *) &dbx_global_mutex);
+
+      if (!got) {
+         break;
+      }
+
+      /* A standby socket with data waiting to be read has been closed by the server */
+      FD_ZERO(&rset);
+      FD_SET(sock, &rset);
+      tval.tv_sec = 0;
+      tval.tv_usec = 0;
+      n = NETX_SELECT((int) (sock + 1), &rset, NULL, NULL, &tval);
+      if (n == 0) {
+         break;
+      }
+      netx_stby_close(sock);
+      got = 0;
+   }
+
+   if (!got) { /* no standby available - reconnect now */
+      if (netx_stby_open(&stby, &sock, error) != CACHE_SUCCESS) {
+         strcpy(pcon->error, error);
+         return 0;
+      }
+   }
+
+   netx_tcp_disconnect(pcon, 0);
+   pcon->cli_socket = sock;
+   pcon->connected = 2;
+   pcon->eof = 0;
+   pcon->error[0] = '\0';
+
+   /* The standby socket may have been opened before the namespace was last changed: set it before anything is sent */
+   if (!netx_stby_namespace(pcon)) {
+      pcon->eof = 1;
+      if (!pcon->error[0]) {
+         strcpy(pcon->error, "Unable to set the namespace for a standby connection");
+      }
+      return 0;
+   }
+
+   mg_enter_critical_section((void *) &dbx_global_mutex);
+   pstby->failovers ++;
+   mg_leave_critical_section((void *) &dbx_global_mutex);
+
+   return 1;
+}
+
+
+/* v1.3.22: change the network connection to the namespace last set for it (a "sns" request) */
+int netx_stby_namespace(DBXCON *pcon)
+{
+   int n, len, total, get;
+   unsigned char buffer[256];
+
+   len = (int) strlen(pcon->nspace);
+   if (pcon->dbtype == DBX_DBTYPE_YOTTADB || len == 0) {
+      return 1;
+   }
+
+   mg_set_size(buffer + 5, (unsigned long) DBX_BUFFER);
+   buffer[9] = (unsigned char) ((DBX_DSORT_DATA * 20) + DBX_DTYPE_INT);
+   mg_set_size(buffer + 10, (unsigned long) pcon->chndle);
+   buffer[14] = (unsigned char) ((DBX_DSORT_DATA * 20) + DBX_DTYPE_INT);
+   mg_set_size(buffer + 15, (unsigned long) len);
+   buffer[19] = (unsigned char) ((DBX_DSORT_DATA * 20) + DBX_DTYPE_STR);
+   memcpy((void *) (buffer + 20), (void *) pcon->nspace, (size_t) len);
+   total = 20 + len;
+   mg_set_size(buffer + total, 0);
+   buffer[total + 4] = (unsigned char) ((DBX_DSORT_EOD * 20) + DBX_DTYPE_STR);
+   total += 5;
+   mg_set_size(buffer, (unsigned long) total);
+   buffer[4] = (unsigned char) DBX_CMND_NSSET;
+
+   if (netx_tcp_write(pcon, buffer, total) < 0) {
+      return 0;
+   }
+   if (netx_tcp_read(pcon, buffer, 5, pcon->timeout, 1) != 5) {
+      return 0;
+   }
+   len = (int) mg_get_size(buffer);
+   n = (int) (buffer[4] / 20);
+   for (total = 0; total < len; total += get) {
+      get = (len - total);
+      if (get > (int) sizeof(buffer))
+         get = (int) sizeof(buffer);
+      if (netx_tcp_read(pcon, buffer, get, pcon->timeout, 1) != get) {
+         return 0;
+      }
+   }
+
+   return (n != DBX_DSORT_ERROR);
+}
+
+
+int netx_stby_open(DBXSTBY *pstby, SOCKET *psocket, char *error)
+{
+   int rc;
+   DBXCON *pcon;
+
+   pcon = (DBXCON *) mg_malloc(sizeof(DBXCON), 0);
+   if (!pcon) {
+      strcpy(error, "Unable to allocate memory for a standby connection");
+      return CACHE_FAILURE;
+   }
+   memset((void *) pcon, 0, sizeof(DBXCON));
+   pcon->p_log = &(pcon->log);
+   pcon->p_zv = &(pcon->zv);
+   pcon->dbtype = pstby->dbtype;
+   pcon->port = pstby->port;
+   pcon->timeout = pstby->timeout;
+   strcpy(pcon->ip_address, pstby->ip_address);
+   strcpy(pcon->nspace, pstby->nspace);
+
+   rc = netx_tcp_connect(pcon, 0);
+   if (rc == CACHE_SUCCESS) {
+      pcon->connected = 2;
+      netx_tcp_handshake(pcon, 0);
+      if (!pcon->connected || pcon->error[0]) {
+         netx_tcp_disconnect(pcon, 0);
+         rc = CACHE_NOCON;
+      }
+   }
+   else {
+      rc = CACHE_NOCON;
+   }
+
+   if (rc == CACHE_SUCCESS) {
+      *psocket = pcon->cli_socket;
+   }
+   else {
+      strcpy(error, pcon->error[0] ? pcon->error : "Connection Error: Unable to open a standby connection");
+   }
+   mg_free((void *) pcon, 0);
+
+   return rc;
+}
+
+
+int netx_stby_close(SOCKET sock)
+{
+#if defined(_WIN32)
+   NETX_CLOSESOCKET(sock);
+#else
+   close(sock);
+#endif
+
+   return 0;
+}
+
+
+/* Start the thread that opens standby connections: called with dbx_global_mutex held */
+int netx_stby_start(void)
+{
+#if defined(_WIN32)
+   HANDLE hthread;
+#else
+   int rc;
+   pthread_t tid;
+   pthread_attr_t attr;
+#endif
+
+   if (dbx_stby_running) {
+      return CACHE_SUCCESS;
+   }
+
+#if defined(_WIN32)
+   hthread = CreateThread(NULL, 0, netx_stby_thread, NULL, 0, NULL);
+   if (!hthread) {
+      return CACHE_FAILURE;
+   }
+   CloseHandle(hthread);
+#else
+   pthread_attr_init(&attr);
+   pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+   rc = pthread_create(&tid, &attr, netx_stby_thread, NULL);
+   pthread_attr_destroy(&attr);
+   if (rc) {
+      return CACHE_FAILURE;
+   }
+#endif
+
+   dbx_stby_running = 1;
+
+   return CACHE_SUCCESS;
+}
+
+
+#if defined(_WIN32)
+DWORD WINAPI netx_stby_thread(LPVOID arg)
+#else
+void * netx_stby_thread(void *arg)
+#endif
+{
+   int n, rc;
+   SOCKET sock;
+   DBXSTBY *pstby, *pprev, *pnext, *ptarget, stby;
+   char error[DBX_ERROR_SIZE];
+
+   for (;;) {
+      mg_enter_critical_section((void *) &dbx_global_mutex);
+
+      /* Release the standby sockets of closed connections and find a connection that needs another */
+      ptarget = NULL;
+      pprev = NULL;
+      for (pstby = dbx_stby_list; pstby; pstby = pnext) {
+         pnext = pstby->pnext;
+         if (pstby->closed) {
+            for (n = 0; n < pstby->count; n ++) {
+               netx_stby_close(pstby->socket[n]);
+            }
+            if (pprev)
+               pprev->pnext = pnext;
+            else
+               dbx_stby_list = pnext;
+            mg_free((void *) pstby, 0);
+            continue;
+         }
+         if (!ptarget && pstby->count < pstby->size) {
+            ptarget = pstby;
+            memcpy((void *) &stby, (void *) pstby, sizeof(DBXSTBY));
+         }
+         pprev = pstby;
+      }
+
+      if (!dbx_stby_list) {
+         dbx_stby_running = 0;
+         mg_leave_critical_section((void *) &dbx_global_mutex);
+         break;
+      }
+
+      /* Move the connection to the end of the list so that the others are served first next time round */
+      if (ptarget && ptarget->pnext) {
+         for (pprev = NULL, pstby = dbx_stby_list; pstby != ptarget; pprev = pstby, pstby = pstby->pnext)
+            ;
+         if (pprev)
+            pprev->pnext = ptarget->pnext;
+         else
+            dbx_stby_list = ptarget->pnext;
+         for (pstby = dbx_stby_list; pstby->pnext; pstby = pstby->pnext)
+            ;
+         pstby->pnext = ptarget;
+         ptarget->pnext = NULL;
+      }
+
+      mg_leave_critical_section((void *) &dbx_global_mutex);
+
+      if (!ptarget) {
+         mg_sleep(DBX_STBY_INTERVAL);
+         continue;
+      }
+
+      rc = netx_stby_open(&stby, &sock, error);
+
+      mg_enter_critical_section((void *) &dbx_global_mutex);
+      /* Only this thread frees a closed pool so ptarget is still valid */
+      if (rc == CACHE_SUCCESS) {
+         if (!ptarget->closed && ptarget->count < ptarget->size) {
+            ptarget->socket[ptarget->count ++] = sock;
+         }
+         else {
+            netx_stby_close(sock);
+         }
+      }
+      mg_leave_critical_section((void *) &dbx_global_mutex);
+
+      if (rc != CACHE_SUCCESS) { /* back off while the server is unavailable */
+         mg_sleep(DBX_STBY_INTERVAL * 4);
+      }
+   }
+
+#if defined(_WIN32)
+   return 0;
+#else
+   return NULL;
+#endif
+}
+
+
+/* v1.3.22: connect to a co-located server listening on a Unix domain socket (host = unix:/path) */
+int netx_unix_connect(DBXCON *pcon, int context)
+{
+#if defined(_WIN32)
+   strcpy(pcon->error, "Connection Error: Unix domain sockets are not supported on this platform");
+   return -5;
+#else
+   int n, errorno;
+   char *path;
+   struct sockaddr_un srv_addr;
+
+   path = pcon->ip_address + NETX_UNIX_PREFIX_LEN;
+   if (!path[0] || strlen(path) >= sizeof(srv_addr.sun_path)) {
+      sprintf(pcon->error, "Connection Error: Invalid Unix domain socket path (%s)", path);
+      return -2;
+   }
+
+   pcon->cli_socket = NETX_SOCKET(AF_UNIX, SOCK_STREAM, 0);
+   if (INVALID_SOCK(pcon->cli_socket)) {
+      char message[256];
+
+      errorno = (int) netx_get_last_error(0);
+      netx_get_error_message(errorno, message, 250, 0);
+      sprintf(pcon->error, "Connection Error: Invalid Socket: Context=4: Error Code: %d (%s)", errorno, message);
+      return -2;
    }
 
-   pmeth->output_val.svalue.len_used = len;
+   BZERO((char *) &srv_addr, sizeof(srv_addr));
+   srv_addr.sun_family = AF_UNIX;
+   strcpy(srv_addr.sun_path, path);
 
-   return rc;
+   pcon->error_no = 0;
+   n = netx_tcp_connect_ex(pcon, (xLPSOCKADDR) &srv_addr, (socklen_netx) sizeof(srv_addr), pcon->timeout);
+   if (n == -2 || SOCK_ERROR(n)) {
+      char message[256];
+
+      errorno = (n == -2) ? n : (int) netx_get_last_error(0);
+      pcon->error_no = errorno;
+      netx_get_error_message(errorno, message, 250, 0);
+      sprintf(pcon->error, "Connection Error: Cannot Connect to Server (%s): Error Code: %d (%s)", (char *) pcon->ip_address, errorno, message);
+      netx_tcp_disconnect(pcon, 0);
+      return -5;
+   }
+
+   pcon->connected = 1;
+   return 0;
+#endif
 }
 
 
@@ -6972,50 +11723,184 @@ int netx_tcp_disconnect(DBXCON *pcon, int context)
 
 int netx_tcp_write(DBXCON *pcon, unsigned char *data, int size)
 {
-   int n = 0, errorno = 0, char_sent = 0;
-   int total;
-   char errormessage[512];
+   NETXIOV iov[1];
+
+   NETX_IOV_BASE(iov[0]) = (char *) data;
+   NETX_IOV_LEN(iov[0]) = size;
 
-   *errormessage = '\0';
+   return netx_tcp_writev(pcon, iov, 1);
+}
+
+
+/* v1.3.21: send a list of buffers as one request - note that the iov array is modified */
+int netx_tcp_writev(DBXCON *pcon, NETXIOV *iov, int iovcnt)
+{
+   int n, errorno, total;
+   char message[256];
+#if defined(_WIN32)
+   DWORD sent;
+#endif
 
-   if (pcon->connected == 0) {
+   if (pcon->connected == 0 || pcon->eof) {
       strcpy(pcon->error, "TCP Write Error: Socket is Closed");
       return -1;
    }
 
    total = 0;
    for (;;) {
-      n = NETX_SEND(pcon->cli_socket, (xLPSENDBUF) (data + total), size - total, 0);
+      /* skip over the buffers (or parts of buffers) already sent */
+      while (iovcnt > 0 && NETX_IOV_LEN(iov[0]) == 0) {
+         iov ++;
+         iovcnt --;
+      }
+      if (iovcnt <= 0) {
+         break;
+      }
 
-      if (SOCK_ERROR(n)) {
+#if defined(_WIN32)
+      if (netx_so.p_WSASend) {
+         sent = 0;
+         n = NETX_WSASEND(pcon->cli_socket, iov, (DWORD) iovcnt, &sent, 0, NULL, NULL);
+         if (n == 0) {
+            n = (int) sent;
+         }
+      }
+      else {
+         n = NETX_SEND(pcon->cli_socket, (xLPSENDBUF) NETX_IOV_BASE(iov[0]), (int) NETX_IOV_LEN(iov[0]), 0);
+      }
+#else
+#if defined(MSG_DONTWAIT)
+      if (pcon->deadline) { /* v1.3.22: don't block beyond the request's deadline */
+         struct msghdr msg;
 
-         errorno = (int) netx_get_last_error(0);
+         memset((void *) &msg, 0, sizeof(msg));
+         msg.msg_iov = iov;
+         msg.msg_iovlen = (iovcnt < NETX_IOV_MAX) ? iovcnt : NETX_IOV_MAX;
+         n = (int) sendmsg(pcon->cli_socket, &msg, MSG_DONTWAIT);
+      }
+      else
+#endif
+      n = (int) writev(pcon->cli_socket, iov, (iovcnt < NETX_IOV_MAX) ? iovcnt : NETX_IOV_MAX);
+#endif
 
+      if (SOCK_ERROR(n)) {
+         errorno = (int) netx_get_last_error(0);
+#if !defined(_WIN32)
+         if (errorno == EINTR) {
+            continue;
+         }
+#endif
          if (NOT_BLOCKING(errorno) && errorno != 0) {
-
-            char message[256];
-
             netx_get_error_message(errorno, message, 250, 0);
             sprintf(pcon->error, "TCP Write Error: Cannot Write Data: Error Code: %d (%s)", errorno, message);
+            return -1;
+         }
+         n = netx_tcp_wait_write(pcon, pcon->timeout);
+         if (n == NETX_READ_DEADLINE) { /* v1.3.22: part of the request may have been sent */
+            strcpy(pcon->error, DBX_DEADLINE_MESSAGE);
+            pcon->eof = 1;
+            return NETX_READ_DEADLINE;
+         }
+         if (n < 1) {
+            strcpy(pcon->error, (n == 0) ? "TCP Write Error: Timeout waiting for the socket to become writable" : "TCP Write Error: Socket error while waiting to write");
+            return -1;
+         }
+         continue;
+      }
 
-            char_sent = -1;
-            break;
+      total += n;
+      while (n > 0) {
+         if ((unsigned long) n >= (unsigned long) NETX_IOV_LEN(iov[0])) {
+            n -= (int) NETX_IOV_LEN(iov[0]);
+            NETX_IOV_LEN(iov[0]) = 0;
+            iov ++;
+            iovcnt --;
+         }
+         else {
+            NETX_IOV_BASE(iov[0]) = (char *) NETX_IOV_BASE(iov[0]) + n;
+            NETX_IOV_LEN(iov[0]) -= n;
+            n = 0;
          }
       }
-      else {
+   }
 
-         total += n;
-         if (total == size) {
-            break;
+   return total;
+}
+
+
+int netx_tcp_wait_write(DBXCON *pcon, int timeout)
+{
+   int n;
+   unsigned long long start;
+   fd_set wset, eset;
+   struct timeval tval;
+
+   timeout = (timeout > 0) ? timeout : NETX_TIMEOUT;
+   tval.tv_sec = timeout;
+   tval.tv_usec = 0;
+
+   start = mg_time_ms();
+   for (;;) {
+      if (pcon->deadline) { /* v1.3.22 */
+         n = netx_tcp_step(pcon, timeout, start, &tval);
+         if (n < 1) {
+            return (n == 0) ? NETX_READ_DEADLINE : 0;
          }
       }
+
+      FD_ZERO(&wset);
+      FD_ZERO(&eset);
+      FD_SET(pcon->cli_socket, &wset);
+      FD_SET(pcon->cli_socket, &eset);
+
+      n = NETX_SELECT((int) (pcon->cli_socket + 1), NULL, &wset, &eset, &tval);
+
+      if (n == 0 && pcon->deadline) {
+         continue;
+      }
+      break;
    }
 
-   if (char_sent < 0)
-      return char_sent;
-   else
-      return size;
+   if (n > 0 && NETX_FD_ISSET(pcon->cli_socket, &eset)) {
+      n = -1;
+   }
+
+   return n;
+}
+
+
+/* v1.3.22: set the next wait in select() for a request with a deadline
+   The wait is taken in short steps so that a request cancelled from another thread is noticed.
+   Returns 1 to wait for 'tval', 0 if the deadline has passed or -1 if the timeout (seconds) has expired
+*/
+int netx_tcp_step(DBXCON *pcon, int timeout, unsigned long long start, struct timeval *tval)
+{
+   int step, remaining;
+   unsigned long long elapsed;
+
+   remaining = mg_deadline_ms(pcon);
+   if (remaining == 0) {
+      return 0;
+   }
+
+   step = DBX_DEADLINE_STEP;
+   if (remaining > 0 && remaining < step) {
+      step = remaining;
+   }
+   if (timeout > 0) {
+      elapsed = mg_time_ms() - start;
+      if (elapsed >= ((unsigned long long) timeout * 1000)) {
+         return -1;
+      }
+      if ((((unsigned long long) timeout * 1000) - elapsed) < (unsigned long long) step) {
+         step = (int) (((unsigned long long) timeout * 1000) - elapsed);
+      }
+   }
+
+   tval->tv_sec = step / 1000;
+   tval->tv_usec = (step % 1000) * 1000;
 
+   return 1;
 }
 
 
@@ -7027,6 +11912,7 @@ int netx_tcp_read(DBXCON *pcon, unsigned char *data, int size, int timeout, int
    fd_set rset, eset;
    struct timeval tval;
    unsigned long spin_count;
+   unsigned long long start;
 
 
    if (!pcon) {
@@ -7038,11 +11924,28 @@ int netx_tcp_read(DBXCON *pcon, unsigned char *data, int size, int timeout, int
    tval.tv_sec = timeout;
    tval.tv_usec = 0;
 
+   start = mg_time_ms();
    spin_count = 0;
    len = 0;
    for (;;) {
       spin_count ++;
 
+      if (pcon->deadline) { /* v1.3.22 */
+         n = netx_tcp_step(pcon, timeout, start, &tval);
+         if (n == 0) {
+            strcpy(pcon->error, DBX_DEADLINE_MESSAGE);
+            pcon->eof = 1; /* the rest of the response can't now be matched to its request */
+            result = NETX_READ_DEADLINE;
+            len = 0;
+            break;
+         }
+         if (n < 0) {
+            sprintf(pcon->error, "TCP Read Error: Server did not respond within the timeout period (%d seconds)", timeout);
+            result = NETX_READ_TIMEOUT;
+            break;
+         }
+      }
+
       FD_ZERO(&rset);
       FD_ZERO(&eset);
       FD_SET(pcon->cli_socket, &rset);
@@ -7051,6 +11954,9 @@ int netx_tcp_read(DBXCON *pcon, unsigned char *data, int size, int timeout, int
       n = NETX_SELECT((int) (pcon->cli_socket + 1), &rset, NULL, &eset, &tval);
 
       if (n == 0) {
+         if (pcon->deadline) {
+            continue;
+         }
          sprintf(pcon->error, "TCP Read Error: Server did not respond within the timeout period (%d seconds)", timeout);
          result = NETX_READ_TIMEOUT;
          break;
@@ -7520,9 +12426,10 @@ int netx_get_std_error_message(int error_code, char *message, int size, int cont
 int mg_db_command(DBXMETH *pmeth, int context)
 {
    MGBUF mgbuf, *p_buf;
-   int n, len, dsort, dtype, chndle;
-   int ifc[4];
-   char *p;
+   MGBUFS *p_bufs;
+   int n, len, dsort, dtype, chndle, nargs, niov;
+   int ifc[4], arg_head[DBX_MAXARGS], arg_len[DBX_MAXARGS];
+   char *p, *arg_data[DBX_MAXARGS];
    MGSRV *p_srv;
    DBXCON *pcon = pmeth->pcon;
 
@@ -7573,14 +12480,22 @@ int mg_db_command(DBXMETH *pmeth, int context)
 */
 
 
-   p_buf = &mgbuf;
-   mg_buf_init(p_buf, MG_BUFSIZE, MG_BUFSIZE);
+   p_bufs = mg_db_buffers(pcon); /* v1.3.22 */
+   if (p_bufs) {
+      p_buf = &(p_bufs->send);
+      p_buf->data_size = 0;
+   }
+   else {
+      p_buf = &mgbuf;
+      mg_buf_init(p_buf, MG_BUFSIZE, MG_BUFSIZE);
+   }
 
    mg_request_header(p_srv, p_buf, pmeth->command, p_srv->product);
 
    ifc[0] = 0;
    ifc[1] = MG_TX_DATA;
 
+   nargs = 0;
    for (;;) {
       len = (int) mg_get_block_size(&(pmeth->input_str), pmeth->offset, &dsort, &dtype);
       pmeth->offset += 5;
@@ -7592,11 +12507,55 @@ int mg_db_command(DBXMETH *pmeth, int context)
       }
       p = (char *) (pmeth->input_str.buf_addr + pmeth->offset);
 
-      mg_request_add(p_srv, chndle, p_buf, (unsigned char *) p, len, (short) ifc[0], (short) ifc[1]);
+      if (p_srv->mode == 2 || nargs == DBX_MAXARGS) { /* the server API needs the whole request in one buffer */
+         mg_request_add(p_srv, chndle, p_buf, (unsigned char *) p, len, (short) ifc[0], (short) ifc[1]);
+      }
+      else { /* v1.3.21: only the item header is added to the buffer - the argument is sent from where it is */
+         if (!mg_buf_resize(p_buf, p_buf->data_size + MG_ITEM_HEAD_MAX)) { /* v1.3.22: header encoded in place */
+            break;
+         }
+         n = mg_encode_item_header(p_buf->p_buffer + p_buf->data_size, len, (short) ifc[0], (short) ifc[1]);
+         p_buf->data_size += n;
+         arg_head[nargs] = (int) p_buf->data_size;
+         arg_data[nargs] = p;
+         arg_len[nargs] = len;
+         nargs ++;
+      }
       pmeth->offset += len;
    }
 
-   mg_db_send(p_srv, chndle, p_buf, 1);
+   if (nargs) { /* v1.3.21 */
+      NETXIOV iov[(DBX_MAXARGS * 2) + 1];
+
+      len = 0;
+      niov = 0;
+      for (n = 0; n < nargs; n ++) {
+         NETX_IOV_BASE(iov[niov]) = (char *) p_buf->p_buffer + len;
+         NETX_IOV_LEN(iov[niov]) = arg_head[n] - len;
+         niov ++;
+         NETX_IOV_BASE(iov[niov]) = arg_data[n];
+         NETX_IOV_LEN(iov[niov]) = arg_len[n];
+         niov ++;
+         len = arg_head[n];
+      }
+      if ((int) p_buf->data_size > len) {
+         NETX_IOV_BASE(iov[niov]) = (char *) p_buf->p_buffer + len;
+         NETX_IOV_LEN(iov[niov]) = p_buf->data_size - len;
+         niov ++;
+      }
+      mg_db_sendv(p_srv, chndle, iov, niov, 1);
+   }
+   else {
+      mg_db_send(p_srv, chndle, p_buf, 1);
+   }
+
+   if (p_srv->mode != 2) { /* v1.3.22 */
+      mg_db_receive_output(p_srv, chndle, pmeth);
+      if (!p_bufs) {
+         mg_buf_free(p_buf);
+      }
+      return 0;
+   }
 
    mg_db_receive(p_srv, chndle, p_buf, MG_BUFSIZE, 0);
 
@@ -7608,7 +12567,9 @@ int mg_db_command(DBXMETH *pmeth, int context)
       mg_set_size((unsigned char *) pmeth->output_val.svalue.buf_addr, len);
       memcpy(pmeth->output_val.svalue.buf_addr + 5, p_buf->p_buffer + MG_RECV_HEAD, len);
       pmeth->output_val.svalue.buf_addr[4] = (dsort * 20) + dtype;
-      mg_buf_free(p_buf);
+      if (!p_bufs) {
+         mg_buf_free(p_buf);
+      }
       return 0;
    }
 
@@ -7620,7 +12581,9 @@ int mg_db_command(DBXMETH *pmeth, int context)
       memcpy(pmeth->output_val.svalue.buf_addr + 5, p_buf->p_buffer + MG_RECV_HEAD, len);
    }
 
-   mg_buf_free(p_buf);
+   if (!p_bufs) {
+      mg_buf_free(p_buf);
+   }
 
    return 0;
 }
@@ -7749,6 +12712,7 @@ int mg_db_disconnect(MGSRV *p_srv, int chndle, short context)
    close(pcon->cli_socket);
 #endif
 
+   mg_db_free_buffers(pcon); /* v1.3.22 */
    mg_free((void *) p_srv->pcon[chndle], 0);
    p_srv->pcon[chndle] = NULL;
 
@@ -7757,23 +12721,42 @@ int mg_db_disconnect(MGSRV *p_srv, int chndle, short context)
 
 int mg_db_send(MGSRV *p_srv, int chndle, MGBUF *p_buf, int mode)
 {
-   int result, n, n1, len, total;
-   char *request;
+   NETXIOV iov[1];
+
+   NETX_IOV_BASE(iov[0]) = (char *) p_buf->p_buffer;
+   NETX_IOV_LEN(iov[0]) = p_buf->data_size;
+
+   return mg_db_sendv(p_srv, chndle, iov, 1, mode);
+}
+
+
+/* v1.3.21: the first buffer must hold the request header */
+int mg_db_sendv(MGSRV *p_srv, int chndle, NETXIOV *iov, int iovcnt, int mode)
+{
+   int result, n, len;
+   unsigned long size;
    unsigned char esize[8];
    DBXCON *pcon;
 
    result = 1;
 
+   size = 0;
+   for (n = 0; n < iovcnt; n ++) {
+      size += (unsigned long) NETX_IOV_LEN(iov[n]);
+   }
+
    if (p_srv->p_log && p_srv->p_log->log_transmissions) {
       char buffer[64];
 
-      sprintf(buffer, "Transmission: Send to Host (size=%lu)", p_buf->data_size);
-      mg_log_buffer(p_srv->p_log, (char *) p_buf->p_buffer, p_buf->data_size, buffer, 0);
+      sprintf(buffer, "Transmission: Send to Host (size=%lu)", size);
+      for (n = 0; n < iovcnt; n ++) {
+         mg_log_buffer(p_srv->p_log, (char *) NETX_IOV_BASE(iov[n]), (int) NETX_IOV_LEN(iov[n]), buffer, 0);
+      }
    }
 
    if (mode) {
-      len = mg_encode_size(esize, p_buf->data_size - p_srv->header_len, MG_CHUNK_SIZE_BASE);
-      strncpy((char *) (p_buf->p_buffer + (p_srv->header_len - 6) + (5 - len)), (char *) esize, len);
+      len = mg_encode_size(esize, size - p_srv->header_len, MG_CHUNK_SIZE_BASE);
+      strncpy(((char *) NETX_IOV_BASE(iov[0])) + (p_srv->header_len - 6) + (5 - len), (char *) esize, len);
    }
 
    if (p_srv->mode == 2) {
@@ -7784,28 +12767,8 @@ int mg_db_send(MGSRV *p_srv, int chndle, MGBUF *p_buf, int mode)
 
    pcon->eod = 0;
 
-   request = (char *) p_buf->p_buffer;
-   len = p_buf->data_size;
-
-   total = 0;
-
-   n1= 0;
-   for (;;) {
-      n = NETX_SEND(pcon->cli_socket, request + total, len - total, 0);
-      if (n < 0) {
-         result = 0;
-         break;
-      }
-
-      total += n;
-
-      if (total == len)
-         break;
-
-      n1 ++;
-      if (n1 > 100000)
-         break;
-
+   if (netx_tcp_writev(pcon, iov, iovcnt) < 0) {
+      result = 0;
    }
 
    return result;
@@ -7820,6 +12783,7 @@ int mg_db_receive(MGSRV *p_srv, int chndle, MGBUF *p_buf, int size, int mode)
    struct timeval tval;
    DBXCON *pcon;
    unsigned long spin_count;
+   unsigned long long start;
 
    if (p_srv->mode == 2) {
       return mg_invoke_server_api(p_srv, chndle, p_buf, size, mode);
@@ -7850,11 +12814,29 @@ int mg_db_receive(MGSRV *p_srv, int chndle, MGBUF *p_buf, int size, int mode)
    else
       total = p_buf->size;
 
+   start = mg_time_ms();
    spin_count = 0;
    for (;;) {
       spin_count ++;
 
       if (pcon->timeout) {
+         if (pcon->deadline) { /* v1.3.22 */
+            n = netx_tcp_step(pcon, pcon->timeout, start, &tval);
+            if (n == 0) {
+               strcpy(pcon->error, DBX_DEADLINE_MESSAGE);
+               pcon->eof = 1;
+               result = NETX_READ_DEADLINE;
+               pcon->eod = 1;
+               break;
+            }
+            if (n < 0) {
+               sprintf(pcon->error, "TCP Read Error: Server did not respond within the timeout period (%d seconds)", pcon->timeout);
+               result = NETX_READ_TIMEOUT;
+               pcon->eod = 1;
+               break;
+            }
+         }
+
          FD_ZERO(&rset);
          FD_ZERO(&eset);
          FD_SET(pcon->cli_socket, &rset);
@@ -7862,6 +12844,10 @@ int mg_db_receive(MGSRV *p_srv, int chndle, MGBUF *p_buf, int size, int mode)
 
          n = NETX_SELECT((int) (pcon->cli_socket + 1), &rset, NULL, &eset, &tval);
 
+         if (n == 0 && pcon->deadline) {
+            continue;
+         }
+
          if (n == 0) {
             sprintf(pcon->error, "TCP Read Error: Server did not respond within the timeout period (%d seconds)", pcon->timeout);
             result = NETX_READ_TIMEOUT;
@@ -7900,8 +12886,8 @@ int mg_db_receive(MGSRV *p_srv, int chndle, MGBUF *p_buf, int size, int mode)
          ssize = mg_decode_size(p_buf->p_buffer, 5, MG_CHUNK_SIZE_BASE);
          total = ssize + MG_RECV_HEAD;
 
-         if (ssize && (ssize + MG_RECV_HEAD) > total) {
-            if (!mg_buf_resize(p_buf, ssize + MG_RECV_HEAD + 32)) {
+         if (ssize && total > p_buf->size) { /* v1.3.22 */
+            if (!mg_buf_resize(p_buf, total)) {
                p_srv->mem_error = 1;
                break;
             }
@@ -7928,6 +12914,143 @@ int mg_db_receive(MGSRV *p_srv, int chndle, MGBUF *p_buf, int size, int mode)
 }
 
 
+/* v1.3.22: read a reply directly into the caller's output buffer */
+int mg_db_receive_output(MGSRV *p_srv, int chndle, DBXMETH *pmeth)
+{
+   int n, len, max, get, total, error;
+   unsigned char head[MG_RECV_HEAD + 1];
+   char buffer[64];
+   char *p, *p8;
+   MGBUF *p_buf;
+   MGBUFS *p_bufs;
+   DBXCON *pcon;
+
+   pcon = p_srv->pcon[chndle];
+   pcon->timeout = p_srv->timeout;
+
+   n = netx_tcp_read(pcon, head, MG_RECV_HEAD, pcon->timeout, 1);
+   pcon->eod = 1;
+   if (n != MG_RECV_HEAD) {
+      strcpy(pcon->error, (n == NETX_READ_TIMEOUT) ? "TCP Read Error: Server did not respond within the timeout period" : "TCP Read Error: Server closed the connection without having returned any data");
+      mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, pcon->error);
+      return CACHE_FAILURE;
+   }
+   head[MG_RECV_HEAD] = '\0';
+   pcon->keep_alive = 1;
+
+   len = (int) mg_decode_size(head, 5, MG_CHUNK_SIZE_BASE);
+   error = mg_get_error(p_srv, (char *) head);
+
+   if (p_srv->p_log && p_srv->p_log->log_transmissions) {
+      sprintf(buffer, "Transmission: Received from Host (size=%d)", len + MG_RECV_HEAD);
+      mg_log_buffer(p_srv->p_log, (char *) head, MG_RECV_HEAD, buffer, 0);
+   }
+
+   max = ((int) pmeth->output_val.svalue.len_alloc - 7); /* 5 Byte header plus 2 spare: a buffer with no room for these is too small for any reply */
+
+   if (len >= max && pmeth->output_val.realloc) {
+      p8 = (char *) mg_malloc(sizeof(char) * (len + 7), 301);
+      if (p8) {
+         if (pmeth->output_val.svalue.buf_addr && pmeth->output_val.realloc == 2) {
+            mg_free((void *) pmeth->output_val.svalue.buf_addr, 301);
+         }
+         pmeth->output_val.realloc = 2; /* subsequent reallocs can free the original */
+         pmeth->output_val.svalue.buf_addr = (char *) p8;
+         pmeth->output_val.svalue.len_alloc = (len + 7);
+         max = len + 1;
+      }
+   }
+
+   if (len < max) {
+      p = (char *) pmeth->output_val.svalue.buf_addr;
+      if (len > 0 && netx_tcp_read(pcon, (unsigned char *) p + 5, len, pcon->timeout, 1) != len) {
+         strcpy(pcon->error, "TCP Read Error: Incomplete reply from the server");
+         mg_set_error_message_ex((unsigned char *) p, pcon->error);
+         return CACHE_FAILURE;
+      }
+      p[len + 5] = '\0';
+      if (len > 0 && p_srv->p_log && p_srv->p_log->log_transmissions) {
+         mg_log_buffer(p_srv->p_log, p + 5, len, buffer, 0);
+      }
+      memset((void *) p, 0, 5);
+      if (error) {
+         for (n = 0; n < len; n ++) {
+            if (p[n + 5] == '%')
+               p[n + 5] = '^';
+         }
+         p[4] = (DBX_DSORT_ERROR * 20) + DBX_DTYPE_DBXSTR;
+      }
+      if (len > 0 || error) {
+         mg_set_size((unsigned char *) p, len);
+      }
+      return CACHE_SUCCESS;
+   }
+
+   /* The reply will not fit in the output buffer: read it through the connection's receive buffer and discard it */
+   p_bufs = mg_db_buffers(pcon);
+   if (p_bufs) {
+      p_buf = &(p_bufs->recv);
+      for (total = 0; total < len; total += get) {
+         get = (len - total);
+         if (get > (int) p_buf->size)
+            get = (int) p_buf->size;
+         if (netx_tcp_read(pcon, p_buf->p_buffer, get, pcon->timeout, 1) != get) {
+            break;
+         }
+         if (p_srv->p_log && p_srv->p_log->log_transmissions) {
+            mg_log_buffer(p_srv->p_log, (char *) p_buf->p_buffer, get, buffer, 0);
+         }
+      }
+   }
+   mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, "Reply from the server is too large for the output buffer");
+
+   return CACHE_STRTOOLONG;
+}
+
+
+MGBUFS * mg_db_buffers(DBXCON *pcon)
+{
+   MGBUFS *p_bufs;
+
+   p_bufs = (MGBUFS *) pcon->p_bufs;
+   if (p_bufs) {
+      return p_bufs;
+   }
+
+   p_bufs = (MGBUFS *) mg_malloc(sizeof(MGBUFS), 0);
+   if (!p_bufs) {
+      return NULL;
+   }
+   if (!mg_buf_init(&(p_bufs->send), MG_BUFSIZE, MG_BUFSIZE) || !mg_buf_init(&(p_bufs->recv), MG_BUFSIZE, MG_BUFSIZE)) {
+      mg_buf_free(&(p_bufs->send));
+      mg_buf_free(&(p_bufs->recv));
+      mg_free((void *) p_bufs, 0);
+      return NULL;
+   }
+   pcon->p_bufs = (void *) p_bufs;
+
+   return p_bufs;
+}
+
+
+int mg_db_free_buffers(DBXCON *pcon)
+{
+   MGBUFS *p_bufs;
+
+   p_bufs = (MGBUFS *) pcon->p_bufs;
+   if (!p_bufs) {
+      return 0;
+   }
+
+   mg_buf_free(&(p_bufs->send));
+   mg_buf_free(&(p_bufs->recv));
+   mg_free((void *) p_bufs, 0);
+   pcon->p_bufs = NULL;
+
+   return 1;
+}
+
+
 int mg_db_connect_init(MGSRV *p_srv, int chndle)
 {
    int result, n, buffer_actual_size, child_port;
@@ -8116,16 +13239,22 @@ int mg_request_add(MGSRV *p_srv, int chndle, MGBUF *p_buf, unsigned char *elemen
 {
 #if 1
    int hlen;
-   unsigned char head[16];
 
    if (type == MG_TX_AREC_FORMATTED) {
       mg_buf_cat(p_buf, (char *) element, size);
       return 1;
    }
-   hlen = mg_encode_item_header(head, size, byref, type);
-   mg_buf_cat(p_buf, (char *) head, hlen);
-   if (size)
-      mg_buf_cat(p_buf, (char *) element, size);
+   /* v1.3.22: make room for the header and data together and encode the header in place */
+   if (!mg_buf_resize(p_buf, p_buf->data_size + size + MG_ITEM_HEAD_MAX)) {
+      return 0;
+   }
+   hlen = mg_encode_item_header(p_buf->p_buffer + p_buf->data_size, size, byref, type);
+   p_buf->data_size += hlen;
+   if (size) {
+      memcpy((void *) (p_buf->p_buffer + p_buf->data_size), (void *) element, size);
+      p_buf->data_size += size;
+   }
+   p_buf->p_buffer[p_buf->data_size] = '\0';
    return 1;
 #else
    unsigned long len;
@@ -8166,12 +13295,8 @@ int mg_request_add(MGSRV *p_srv, int chndle, MGBUF *p_buf, unsigned char *elemen
 
 int mg_encode_size64(int n10)
 {
-   if (n10 >= 0 && n10 < 10)
-      return (48 + n10);
-   if (n10 >= 10 && n10 < 36)
-      return (65 + (n10 - 10));
-   if (n10 >= 36 && n10 < 62)
-      return  (97 + (n10 - 36));
+   if (n10 >= 0 && n10 < 62)
+      return (int) mg_size64_enc[n10];
 
    return 0;
 }
@@ -8179,63 +13304,65 @@ int mg_encode_size64(int n10)
 
 int mg_decode_size64(int nxx)
 {
-   if (nxx >= 48 && nxx < 58)
-      return (nxx - 48);
-   if (nxx >= 65 && nxx < 91)
-      return ((nxx - 65) + 10);
-   if (nxx >= 97 && nxx < 123)
-      return ((nxx - 97) + 36);
-
-   return 0;
+   return (int) mg_size64_dec[nxx & 0xff];
 }
 
 
 int mg_encode_size(unsigned char *esize, int size, short base)
 {
-   if (base == 10) {
+   int len;
+   unsigned int x;
+   unsigned char buffer[32], *p;
+
+   if (size < 0) {
       sprintf((char *) esize, "%d", size);
       return (int) strlen((char *) esize);
    }
-   else {
-      int n, n1, x;
-      char buffer[32];
-
-      n1 = 31;
-      buffer[n1 --] = '\0';
-      buffer[n1 --] = mg_encode_size64(size  % base);
 
-      for (n = 1;; n ++) {
-         x = (size / ((int) pow(base, n)));
-         if (!x)
-            break;
-         buffer[n1 --] = mg_encode_size64(x  % base);
-      }
-      n1 ++;
-      strcpy((char *) esize, buffer + n1);
-      return (int) strlen((char *) esize);
+   /* v1.3.22: integer arithmetic and table lookup in place of pow() and sprintf() */
+   p = buffer + sizeof(buffer);
+   x = (unsigned int) size;
+   if (base == 10) {
+      do {
+         *(-- p) = (unsigned char) ('0' + (x % 10));
+         x /= 10;
+      } while (x);
+   }
+   else {
+      do {
+         *(-- p) = mg_size64_enc[x % base];
+         x /= base;
+      } while (x);
    }
+   len = (int) ((buffer + sizeof(buffer)) - p);
+   memcpy((void *) esize, (void *) p, len);
+   esize[len] = '\0';
+
+   return len;
 }
 
 
 int mg_decode_size(unsigned char *esize, int len, short base)
 {
-   int size;
-   unsigned char c;
+   int n, size, sign;
 
-   if (base == 10) {
-      c = *(esize + len);
-      *(esize + len) = '\0';
-      size = (int) strtol((char *) esize, NULL, 10);
-      *(esize + len) = c;
+   size = 0;
+   if (base == 10) { /* as strtol(): leading white space and an optional sign */
+      for (n = 0; n < len && (esize[n] == ' ' || (esize[n] >= '\t' && esize[n] <= '\r')); n ++)
+         ;
+      sign = 1;
+      if (n < len && (esize[n] == '-' || esize[n] == '+')) {
+         sign = (esize[n] == '-') ? -1 : 1;
+         n ++;
+      }
+      for (; n < len && esize[n] >= '0' && esize[n] <= '9'; n ++) {
+         size = (size * 10) + (esize[n] - '0');
+      }
+      size *= sign;
    }
    else {
-      int n, x;
-
-      size = 0;
-      for (n = len - 1; n >= 0; n --) {
-
-         x = (int) esize[n];
-         size = size + mg_decode_size64(x) * ((int) pow((double) base, ((double) (len - (n + 1)))));
+      for (n = 0; n < len; n ++) {
+         size = (size * base) + mg_size64_dec[esize[n]];
       }
    }
 
@@ -8247,13 +13374,11 @@ int mg_encode_item_header(unsigned char * head, int size, short byref, short typ
 {
    int slen, hlen;
    unsigned int code;
-   unsigned char esize[16];
 
-   slen = mg_encode_size(esize, size, 10);
+   slen = mg_encode_size(head + 1, size, 10);
 
    code = slen + (type * 8) + (byref * 64);
    head[0] = (unsigned char) code;
-   strncpy((char *) (head + 1), (char *) esize, slen);
 
    hlen = slen + 1;
    head[hlen] = '0';
@@ -8563,6 +13688,7 @@ int mg_release_server_api(MGSRV *p_srv, short context)
    char buffer[256];
    DBXMETH *pmeth;
    DBXCON *pcon;
+   DBXYDBSO *p_ydb_so;
 
    result = 1;
    chndle = 0;
@@ -8571,8 +13697,11 @@ int mg_release_server_api(MGSRV *p_srv, short context)
    pmeth = (DBXMETH *) pcon->pmeth_base;
 
    if (pcon->dbtype == DBX_DBTYPE_YOTTADB) {
-      if (pcon->p_ydb_so->loaded) {
-         rc = pcon->p_ydb_so->p_ydb_exit();
+      ydb_ci_free(pcon); /* v1.3.22 */
+
+      p_ydb_so = pcon->p_ydb_so;
+      if (mg_library_release(pcon) <= 0 && p_ydb_so->loaded) { /* v1.3.22: the runtime is shared, so shut it down with the last connection */
+         rc = p_ydb_so->p_ydb_exit();
          /* printf("\r\np_ydb_exit=%d\r\n", rc); */
       }
 
@@ -8582,9 +13711,6 @@ int mg_release_server_api(MGSRV *p_srv, short context)
       pcon->p_ydb_so->p_library = NULL;
       pcon->p_ydb_so->loaded = 0;
 */
-      strcpy(pcon->p_ydb_so->libdir, "");
-      strcpy(pcon->p_ydb_so->libnam, "");
-
    }
    else if (pcon->dbtype == DBX_DBTYPE_GTM) {
       if (pcon->p_gtm_so->loaded) {
@@ -8619,13 +13745,7 @@ int mg_release_server_api(MGSRV *p_srv, short context)
 
       strcpy(pcon->error, "");
 
-      mg_dso_unload(pcon->p_isc_so->p_library); 
-
-      pcon->p_isc_so->p_library = NULL;
-      pcon->p_isc_so->loaded = 0;
-
-      strcpy(pcon->p_isc_so->libdir, "");
-      strcpy(pcon->p_isc_so->libnam, "");
+      mg_library_release(pcon); /* v1.3.22 */
    }
 
    if (pmeth) { /* 1.3.10 */
@@ -90,6 +90,7 @@
 #include <sys/wait.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <sys/uio.h>
 #include <sys/resource.h>
 #if !defined(HPUX) && !defined(HPUX10) && !defined(HPUX11)
 #include <sys/select.h>
@@ -234,6 +235,9 @@ typedef int                (*ydb_tpfnptr_t) (void *tpfnparm);
 #define YDB_LOCK_TIMEOUT   (YDB_INT_MAX - 4)
 #define YDB_NOTOK          (YDB_INT_MAX - 5)
 
+#define YDB_ERR_NODEEND    -151027672
+#define YDB_ERR_GVUNDEF    -150372994
+
 #define YDB_MAX_TP         32
 #define YDB_TPCTX_DB       1
 #define YDB_TPCTX_TLEVEL   2
@@ -243,6 +247,8 @@ typedef int                (*ydb_tpfnptr_t) (void *tpfnparm);
 #define YDB_TPCTX_QUERY    11
 #define YDB_TPCTX_ORDER    12
 
+#define YDB_NOTTP          0
+
 typedef struct {
    unsigned int   len_alloc;
    unsigned int   len_used;
@@ -263,6 +269,7 @@ typedef ydb_buffer_t DBXSTR;
 typedef char         ydb_char_t;
 typedef long         ydb_long_t;
 typedef int          (*ydb_tpfnptr_t) (void *tpfnparm);  
+typedef int          (*ydb_tp2fnptr_t) (unsigned long long tptoken, ydb_buffer_t *errstr, void *tpfnparm);
 
 
 /* End of YottaDB */
@@ -339,6 +346,9 @@ typedef int    xc_status_t;
 #define DBX_CMND_CSETP           43
 #define DBX_CMND_CMETH           44
 #define DBX_CMND_CCLOSE          45
+#define DBX_CMND_CGETPS          46
+#define DBX_CMND_CSETPS          47
+#define DBX_CMND_CCLOSES         48
 
 #define DBX_CMND_TSTART          61
 #define DBX_CMND_TLEVEL          62
@@ -355,6 +365,40 @@ typedef int    xc_status_t;
 #define DBX_YDB_MAXSIZE          1048576
 #define DBX_YDB_BUFFER           1048577
 
+/* v1.3.18 */
+#define DBX_MAXKEY               1024
+
+/* v1.3.19 */
+#define DBX_CACHE_MAXGLOBALS     32
+#define DBX_CACHE_HASHSIZE       4096
+#define DBX_CACHE_MAXENTRIES     10000
+#define DBX_CACHE_MAXSIZE        8388608
+
+/* v1.3.20 */
+#define DBX_WBUF_HASHSIZE        1024
+#define DBX_WBUF_MAXSIZE         1048576
+#define DBX_WBUF_OUTPUT          (DBX_ERROR_SIZE + 32)
+
+/* v1.3.22 */
+#define DBX_STBY_MAX             8
+#define DBX_STBY_INTERVAL        250
+
+#define DBX_YLOCK_MAX            11 /* v1.3.22: maximum number of names for one call to ydb_lock_s() */
+#define DBX_YLOCK_ARGS(N)        pvar[N], nsub[N], psub[N]
+
+#define DBX_CI_MAX               32 /* v1.3.22: call-in descriptors cached for each connection */
+#define DBX_CI_NAMELEN           64
+#define DBX_FREF_MAX             32 /* v1.3.22: function references (label^routine) cached for each connection */
+#define DBX_FREF_SIZE            128
+#define DBX_OREF_SIZE            64 /* v1.3.22: initial size of the table of OREFs held by a connection */
+#define DBX_API_VERSION          1 /* v1.3.22: version of the DBXAPI table */
+#define DBX_ARENA_SIZE           262144 /* v1.3.22: size of the arena for transient allocations made by each connection */
+#define DBX_DEADLINE_STEP        50 /* v1.3.22: (ms) waits made within a request's deadline are taken in steps of this length so that a cancelled request is noticed */
+#define DBX_DEADLINE_EXCEEDED    -201
+#define DBX_DEADLINE_MESSAGE     "Request deadline exceeded"
+#define DBX_CI_ARGS4(N)          argv[N], argv[N + 1], argv[N + 2], argv[N + 3]
+#define DBX_CI_ARGS16(N)         DBX_CI_ARGS4(N), DBX_CI_ARGS4(N + 4), DBX_CI_ARGS4(N + 8), DBX_CI_ARGS4(N + 12)
+
 #if defined(MAX_PATH) && (MAX_PATH>511)
 #define DBX_MAX_PATH             MAX_PATH
 #else
@@ -389,9 +433,19 @@ typedef int    xc_status_t;
 #define DBX_MEMCPY(a,b,c)           memcpy(a,b,c)
 #endif
 
+/* v1.3.22: a request with a deadline gives up waiting for the connection when the deadline passes */
 #define DBX_LOCK(RC, TIMEOUT) \
    if (pcon->use_db_mutex) { \
-      RC = mg_mutex_lock(pcon->p_db_mutex, TIMEOUT); \
+      if (pcon->deadline) { \
+         RC = mg_mutex_lock_deadline(pcon->p_db_mutex, pcon); \
+         if (RC == DBX_DEADLINE_EXCEEDED) { \
+            mg_set_error_message_ex((unsigned char *) pmeth->output_val.svalue.buf_addr, (char *) DBX_DEADLINE_MESSAGE); \
+            return 0; \
+         } \
+      } \
+      else { \
+         RC = mg_mutex_lock(pcon->p_db_mutex, TIMEOUT); \
+      } \
    } \
 
 #define DBX_UNLOCK(RC) \
@@ -399,6 +453,30 @@ typedef int    xc_status_t;
       RC = mg_mutex_unlock(pcon->p_db_mutex); \
    } \
 
+/* v1.3.22: run requests for a connection with its own InterSystems session thread in that thread */
+#define DBX_SESSION_CALL(FUN, INPUT, OUTPUT) \
+   if (isc_session(INPUT)) { \
+      return isc_session_call(FUN, INPUT, OUTPUT); \
+   } \
+
+/* v1.3.22: thread local storage */
+#if defined(_WIN32)
+#define DBX_TLS                     __declspec(thread)
+#else
+#define DBX_TLS                     __thread
+#endif
+
+/* v1.3.20: apply any buffered Set operations before the connection is used for anything else */
+/* A buffered Set that fails is reported against the request that caused the buffer to be written */
+#define DBX_WBUF_FLUSH(PCON) \
+   if (PCON->p_wbuf && ((DBXWBUF *) PCON->p_wbuf)->entries) { \
+      if (mg_wbuf_flush(PCON) != CACHE_SUCCESS) { \
+         mg_wbuf_error(pmeth); \
+         DBX_UNLOCK(rc); \
+         return 0; \
+      } \
+   } \
+
 
 #define NETX_TIMEOUT             30
 #define NETX_IPV6                1
@@ -406,7 +484,11 @@ typedef int    xc_status_t;
 #define NETX_READ_NOCON          -1
 #define NETX_READ_ERROR          -2
 #define NETX_READ_TIMEOUT        -3
+#define NETX_READ_DEADLINE       -4 /* v1.3.22 */
 #define NETX_RECV_BUFFER         32768
+#define NETX_UNIX_PREFIX         "unix:" /* v1.3.22 */
+#define NETX_UNIX_PREFIX_LEN     5
+#define NETX_IOV_MAX             16
 
 #if defined(LINUX)
 #define NETX_MEMCPY(a,b,c)       memmove(a,b,c)
@@ -492,6 +574,11 @@ typedef size_t          socklen_netx;
 #define INVALID_SOCK(n) (n == INVALID_SOCKET)
 #define NOT_BLOCKING(n) (n != WSAEWOULDBLOCK)
 
+/* v1.3.21 */
+typedef WSABUF          NETXIOV;
+#define NETX_IOV_BASE(v)   (v).buf
+#define NETX_IOV_LEN(v)    (v).len
+
 #define BZERO(b,len) (memset((b), '\0', (len)), (void) 0)
 
 #else /* #if defined(_WIN32) */
@@ -584,6 +671,11 @@ typedef size_t          socklen_netx;
 #define INVALID_SOCK(n) (n < 0)
 #define NOT_BLOCKING(n) (n != EWOULDBLOCK && n != 2)
 
+/* v1.3.21 */
+typedef struct iovec    NETXIOV;
+#define NETX_IOV_BASE(v)   (v).iov_base
+#define NETX_IOV_LEN(v)    (v).iov_len
+
 #define BZERO(b, len)   (bzero(b, len))
 
 #endif /* #if defined(_WIN32) */
@@ -960,6 +1052,7 @@ typedef struct tagDBXISCSO {
 
 typedef struct tagDBXYDBSO {
    short             loaded;
+   short             threaded; /* v1.3.22 */
    char              libdir[256];
    char              libnam[256];
    char              funprfx[8];
@@ -983,12 +1076,34 @@ typedef struct tagDBXYDBSO {
    int               (* p_ydb_cip)                       (ci_name_descriptor *ci_info, ...);
    int               (* p_ydb_lock_incr_s)               (unsigned long long timeout_nsec, ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray);
    int               (* p_ydb_lock_decr_s)               (ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray);
+   int               (* p_ydb_lock_s)                    (unsigned long long timeout_nsec, int namecount, ...); /* v1.3.22 */
    void              (* p_ydb_zstatus)                   (ydb_char_t* msg_buffer, ydb_long_t buf_len);
    int               (* p_ydb_tp_s)                      (ydb_tpfnptr_t tpfn, void *tpfnparm, const char *transid, int namecount, ydb_buffer_t *varnames);
 
 } DBXYDBSO, *PDBXYDBSO;
 
 
+/* v1.3.22: YottaDB SimpleThreadAPI, one per process */
+typedef struct tagDBXYDBST {
+   short             mode; /* 0: not selected; 1: SimpleAPI; 2: SimpleThreadAPI */
+
+   int               (* p_ydb_data_st)                   (unsigned long long tptoken, ydb_buffer_t *errstr, ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray, unsigned int *ret_value);
+   int               (* p_ydb_delete_st)                 (unsigned long long tptoken, ydb_buffer_t *errstr, ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray, int deltype);
+   int               (* p_ydb_set_st)                    (unsigned long long tptoken, ydb_buffer_t *errstr, ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray, ydb_buffer_t *value);
+   int               (* p_ydb_get_st)                    (unsigned long long tptoken, ydb_buffer_t *errstr, ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray, ydb_buffer_t *ret_value);
+   int               (* p_ydb_subscript_next_st)         (unsigned long long tptoken, ydb_buffer_t *errstr, ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray, ydb_buffer_t *ret_value);
+   int               (* p_ydb_subscript_previous_st)     (unsigned long long tptoken, ydb_buffer_t *errstr, ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray, ydb_buffer_t *ret_value);
+   int               (* p_ydb_node_next_st)              (unsigned long long tptoken, ydb_buffer_t *errstr, ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray, int *ret_subs_used, ydb_buffer_t *ret_subsarray);
+   int               (* p_ydb_node_previous_st)          (unsigned long long tptoken, ydb_buffer_t *errstr, ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray, int *ret_subs_used, ydb_buffer_t *ret_subsarray);
+   int               (* p_ydb_incr_st)                   (unsigned long long tptoken, ydb_buffer_t *errstr, ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray, ydb_buffer_t *increment, ydb_buffer_t *ret_value);
+   int               (* p_ydb_cip_t)                     (unsigned long long tptoken, ydb_buffer_t *errstr, ci_name_descriptor *ci_info, ...);
+   int               (* p_ydb_lock_incr_st)              (unsigned long long tptoken, ydb_buffer_t *errstr, unsigned long long timeout_nsec, ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray);
+   int               (* p_ydb_lock_decr_st)              (unsigned long long tptoken, ydb_buffer_t *errstr, ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray);
+   int               (* p_ydb_tp_st)                     (unsigned long long tptoken, ydb_buffer_t *errstr, ydb_tp2fnptr_t tpfn, void *tpfnparm, const char *transid, int namecount, ydb_buffer_t *varnames);
+
+} DBXYDBST, *PDBXYDBST;
+
+
 typedef struct tagDBXGTMSO {
    short             loaded;
    char              libdir[256];
@@ -1003,6 +1118,143 @@ typedef struct tagDBXGTMSO {
 } DBXGTMSO, *PDBXGTMSO;
 
 
+/* v1.3.22: process-wide registry of loaded database libraries (DBXISCSO or DBXYDBSO), keyed by type and path */
+typedef struct tagDBXLIBREG {
+   int               dbtype;
+   int               refs;
+   char              shdir[256];
+   void *            p_so;
+   struct tagDBXLIBREG *pnext;
+} DBXLIBREG, *PDBXLIBREG;
+
+
+/* v1.3.22: table of the entry points to this library returned by dbx_get_api() */
+/* New members are only ever added at the end: a binding can test for them by checking 'size' */
+typedef struct tagDBXAPI {
+   int               version;
+   int               size;
+   int               (* p_init)                          (void);
+   int               (* p_version)                       (int index, char *output, int output_len);
+   int               (* p_open)                          (unsigned char *input, unsigned char *output);
+   int               (* p_close)                         (unsigned char *input, unsigned char *output);
+   int               (* p_set)                           (unsigned char *input, unsigned char *output);
+   int               (* p_get)                           (unsigned char *input, unsigned char *output);
+   int               (* p_next)                          (unsigned char *input, unsigned char *output);
+   int               (* p_next_data)                     (unsigned char *input, unsigned char *output);
+   int               (* p_previous)                      (unsigned char *input, unsigned char *output);
+   int               (* p_previous_data)                 (unsigned char *input, unsigned char *output);
+   int               (* p_nextnode)                      (unsigned char *input, unsigned char *output);
+   int               (* p_nextnode_data)                 (unsigned char *input, unsigned char *output);
+   int               (* p_previousnode)                  (unsigned char *input, unsigned char *output);
+   int               (* p_previousnode_data)             (unsigned char *input, unsigned char *output);
+   int               (* p_delete)                        (unsigned char *input, unsigned char *output);
+   int               (* p_defined)                       (unsigned char *input, unsigned char *output);
+   int               (* p_increment)                     (unsigned char *input, unsigned char *output);
+   int               (* p_merge)                         (unsigned char *input, unsigned char *output);
+   int               (* p_lock)                          (unsigned char *input, unsigned char *output);
+   int               (* p_unlock)                        (unsigned char *input, unsigned char *output);
+   int               (* p_lock_many)                     (unsigned char *input, unsigned char *output);
+   int               (* p_unlock_many)                   (unsigned char *input, unsigned char *output);
+   int               (* p_lock_stats)                    (unsigned char *input, unsigned char *output);
+   int               (* p_tstart)                        (unsigned char *input, unsigned char *output);
+   int               (* p_tlevel)                        (unsigned char *input, unsigned char *output);
+   int               (* p_tcommit)                       (unsigned char *input, unsigned char *output);
+   int               (* p_trollback)                     (unsigned char *input, unsigned char *output);
+   int               (* p_function)                      (unsigned char *input, unsigned char *output);
+   int               (* p_classmethod)                   (unsigned char *input, unsigned char *output);
+   int               (* p_method)                        (unsigned char *input, unsigned char *output);
+   int               (* p_getproperty)                   (unsigned char *input, unsigned char *output);
+   int               (* p_setproperty)                   (unsigned char *input, unsigned char *output);
+   int               (* p_getproperties)                 (unsigned char *input, unsigned char *output);
+   int               (* p_setproperties)                 (unsigned char *input, unsigned char *output);
+   int               (* p_closeinstance)                 (unsigned char *input, unsigned char *output);
+   int               (* p_closeinstances)                (unsigned char *input, unsigned char *output);
+   int               (* p_getnamespace)                  (unsigned char *input, unsigned char *output);
+   int               (* p_setnamespace)                  (unsigned char *input, unsigned char *output);
+   int               (* p_sleep)                         (int period_ms);
+   int               (* p_benchmark)                     (unsigned char *inputstr, unsigned char *outputstr);
+   int               (* p_cache_global)                  (char *global, int ttl);
+   int               (* p_cache_limits)                  (int max_entries, int max_size);
+   int               (* p_cache_clear)                   (void);
+   int               (* p_buffer)                        (unsigned char *input, unsigned char *output);
+   int               (* p_flush)                         (unsigned char *input, unsigned char *output);
+   int               (* p_standby)                       (unsigned char *input, unsigned char *output);
+   int               (* p_deadline)                      (int index, int period_ms);
+} DBXAPI, *PDBXAPI;
+
+
+/* v1.3.22: bump allocator for the transient memory used by a request: reset at the end of each request */
+typedef struct tagDBXARENA {
+   unsigned char *   p_block;
+   unsigned long     size;
+   unsigned long     used;
+   void *            p_overflow; /* heap blocks for requests that do not fit, chained through their first word */
+   unsigned long     overflows;
+} DBXARENA, *PDBXARENA;
+
+
+/* v1.3.22: lock statistics for a connection */
+/* v1.3.22: a node locked through a connection, identified by a hash of its global name and subscripts */
+typedef struct tagDBXLNODE {
+   unsigned long        hash;
+   int                  count;
+} DBXLNODE, *PDBXLNODE;
+
+typedef struct tagDBXLSTAT {
+   unsigned long        locks;
+   unsigned long        timeouts;
+   unsigned long long   wait_ms;
+   unsigned long long   wait_max;
+   unsigned long        holds;
+   unsigned long long   hold_ms;
+   unsigned long long   hold_max;
+   unsigned long long   hold_start;
+   int                  held;
+   int                  nnodes;
+   int                  max_nodes;
+   DBXLNODE *           p_nodes;
+} DBXLSTAT, *PDBXLSTAT;
+
+/* v1.3.22: call-in descriptors for ydb_cip() */
+typedef struct tagDBXCI {
+   char                 name[DBX_CI_NAMELEN];
+   ci_name_descriptor   desc;
+} DBXCI, *PDBXCI;
+
+typedef struct tagDBXCITAB {
+   int            used;
+   int            next;
+   DBXCI          ci[DBX_CI_MAX];
+} DBXCITAB, *PDBXCITAB;
+
+/* v1.3.22: parsed function references (label^routine) */
+typedef struct tagDBXFREF {
+   int            ref_len;
+   char           ref[DBX_FREF_SIZE];
+   char           buffer[DBX_FREF_SIZE];
+   int            label_len;
+   int            routine_len;
+   unsigned int   rflag;
+} DBXFREF, *PDBXFREF;
+
+typedef struct tagDBXFREFTAB {
+   int            used;
+   int            next;
+   DBXFREF        fref[DBX_FREF_MAX];
+} DBXFREFTAB, *PDBXFREFTAB;
+
+/* v1.3.22: OREFs held by a connection, with the number of references handed out for each */
+typedef struct tagDBXOREF {
+   int            oref;
+   int            refs;
+} DBXOREF, *PDBXOREF;
+
+typedef struct tagDBXOREFTAB {
+   int            size;
+   int            used;
+   DBXOREF *      orefs;
+} DBXOREFTAB, *PDBXOREFTAB;
+
 typedef struct tagDBXCON {
    short          dbtype;
    unsigned long  pid;
@@ -1010,6 +1262,7 @@ typedef struct tagDBXCON {
    char           username[64];
    char           password[64];
    char           nspace[64];
+   char           cur_nspace[72]; /* v1.3.22 */
    char           input_device[64];
    char           output_device[64];
    char           debug_str[64];
@@ -1040,6 +1293,21 @@ typedef struct tagDBXCON {
    int            tlevel;
    void *         pthrt[YDB_MAX_TP];
 
+   /* v1.3.20 */
+   void *         p_wbuf;
+
+   /* v1.3.22 */
+   void *         p_bufs;
+   void *         p_stby;
+   DBXLSTAT       lstat;
+   void *         p_ci;
+   void *         p_fref;
+   void *         p_oref;
+   short          threaded;
+   void *         p_sess;
+   DBXARENA       arena;
+   volatile unsigned long long deadline; /* time (ms) by which the current request must complete: zero if there is no deadline */
+
    /* Old MGWSI protocol */
 
    short          eod;
@@ -1064,6 +1332,8 @@ typedef struct tagDBXMETH {
    short          increment;
    short          merge;
    short          getdata; /* v1.3.13 */
+   short          query; /* v1.3.18 */
+   short          dir;
    int            binary;
    int            argc;
    DBXSTR         input_str;
@@ -1090,11 +1360,119 @@ typedef struct tagDBXTHRT {
    pthread_mutex_t   res_cv_mutex;
    pthread_cond_t    res_cv;
 #endif
+   unsigned long long tptoken; /* v1.3.22 */
    int               task_id;
    DBXMETH           *pmeth;
 } DBXTHRT, *PDBXTHRT;
 
 
+/* v1.3.22: InterSystems callin session bound to a thread of its own */
+typedef struct tagDBXSESS {
+   int               request;
+   int               done;
+   int               end;
+   int               users;
+   int               rc;
+   int               (* p_fun)                           (unsigned char *input, unsigned char *output);
+   unsigned char     *input;
+   unsigned char     *output;
+   DBXCON            *pcon;
+#if defined(_WIN32)
+   HANDLE            hthread;
+   DWORD             tid;
+   CRITICAL_SECTION  call_mutex;
+   HANDLE            req_event;
+   HANDLE            res_event;
+#else
+   pthread_t         tid;
+   pthread_mutex_t   call_mutex;
+   pthread_mutex_t   cv_mutex;
+   pthread_cond_t    req_cv;
+   pthread_cond_t    res_cv;
+#endif
+} DBXSESS, *PDBXSESS;
+
+
+/* v1.3.19 */
+typedef struct tagDBXCENT {
+   unsigned long        hash;
+   unsigned long long   expiry;
+   int                  key_len;
+   int                  data_len;
+   unsigned char *      key;
+   unsigned char *      data;
+   struct tagDBXCENT *  pnext;
+   struct tagDBXCENT *  plru_prev;
+   struct tagDBXCENT *  plru_next;
+} DBXCENT, *PDBXCENT;
+
+typedef struct tagDBXCGLO {
+   int               ttl;
+   int               name_len;
+   char              name[64];
+} DBXCGLO, *PDBXCGLO;
+
+typedef struct tagDBXCACHE {
+   int               globals;
+   int               max_entries;
+   unsigned long     max_size;
+   int               entries;
+   unsigned long     size;
+   unsigned long     hits;
+   unsigned long     misses;
+   unsigned long long generation;
+   DBXCGLO           global[DBX_CACHE_MAXGLOBALS];
+   DBXCENT *         table[DBX_CACHE_HASHSIZE];
+   DBXCENT *         plru_head;
+   DBXCENT *         plru_tail;
+} DBXCACHE, *PDBXCACHE;
+
+
+/* v1.3.20 */
+typedef struct tagDBXWENT {
+   unsigned long        hash;
+   int                  offset;
+   int                  key_len;
+   int                  req_len;
+   unsigned char *      req;
+   struct tagDBXWENT *  pnext;
+   struct tagDBXWENT *  plist_next;
+} DBXWENT, *PDBXWENT;
+
+typedef struct tagDBXWBUF {
+   int                  max_entries;
+   unsigned long        max_size;
+   int                  max_age;
+   int                  entries;
+   unsigned long        size;
+   unsigned long long   first;
+   unsigned long        sets;
+   unsigned long        writes;
+   char                 error[DBX_ERROR_SIZE];
+   DBXMETH              meth;
+   unsigned char        output[DBX_WBUF_OUTPUT];
+   DBXWENT *            table[DBX_WBUF_HASHSIZE];
+   DBXWENT *            plist_head;
+   DBXWENT *            plist_tail;
+} DBXWBUF, *PDBXWBUF;
+
+/* v1.3.22: pre-connected standby sockets for a network connection */
+typedef struct tagDBXSTBY {
+   int                  size;
+   int                  count;
+   int                  closed;
+   int                  tlevel;
+   unsigned long        failovers;
+   SOCKET               socket[DBX_STBY_MAX];
+   short                dbtype;
+   int                  port;
+   int                  timeout;
+   char                 ip_address[128];
+   char                 nspace[64];
+   struct tagDBXSTBY *  pnext;
+} DBXSTBY, *PDBXSTBY;
+
+
 #define MG_HOST                  "127.0.0.1"
 #if defined(MG_DEFAULT_PORT)
 #define MG_PORT                  MG_DEFAULT_PORT
@@ -1124,6 +1502,7 @@ typedef struct tagDBXTHRT {
 #define MG_TX_AREC_FORMATTED     9
 
 #define MG_RECV_HEAD             8
+#define MG_ITEM_HEAD_MAX         16
 
 #define MG_CHUNK_SIZE_BASE       62
 
@@ -1140,6 +1519,12 @@ typedef struct tagMGBUF {
    unsigned char *   p_buffer;
 } MGBUF, *LPMGBUF;
 
+/* v1.3.22: persistent buffers for the old MGWSI protocol */
+typedef struct tagMGBUFS {
+   MGBUF             send;
+   MGBUF             recv;
+} MGBUFS, *LPMGBUFS;
+
 typedef struct tagMGSTR {
    unsigned int      size;
    unsigned char *   ps;
@@ -1158,7 +1543,7 @@ typedef struct tagMGSRV {
    char        server[64];
    char        uci[128];
    char        shdir[256];
-   char        ip_address[64];
+   char        ip_address[128]; /* v1.3.22: as DBXCON - long enough for a unix:/path host */
    int         port;
    int         timeout;
    int         no_retry;
@@ -1184,8 +1569,14 @@ extern MG_MALLOC     dbx_ext_malloc;
 extern MG_REALLOC    dbx_ext_realloc;
 extern MG_FREE       dbx_ext_free;
 
+#if defined(MG_PGO) /* v1.3.22: profile guided optimization (see Makefile): libgcov is only linked into the instrumented build */
+extern void          __gcov_dump       (void) __attribute__((weak));
+extern void          __gcov_reset      (void) __attribute__((weak));
+#endif
+
 DBX_EXTFUN(int)         dbx_init                      ();
 DBX_EXTFUN(int)         dbx_version                   (int index, char *output, int output_len);
+DBX_EXTFUN(DBXAPI *)    dbx_get_api                   (int version);
 DBX_EXTFUN(int)         dbx_open                      (unsigned char *input, unsigned char *output);
 DBX_EXTFUN(int)         dbx_close                     (unsigned char *input, unsigned char *output);
 DBX_EXTFUN(int)         dbx_set                       (unsigned char *input, unsigned char *output);
@@ -1204,6 +1595,16 @@ DBX_EXTFUN(int)         dbx_previous_x                (DBXMETH *pmeth);
 DBX_EXTFUN(int)         dbx_previous_data             (unsigned char *input, unsigned char *output);
 DBX_EXTFUN(int)         dbx_previous_data_x           (DBXMETH *pmeth);
 DBX_EXTFUN(int)         dbx_previous_ex               (DBXMETH *pmeth);
+DBX_EXTFUN(int)         dbx_nextnode                  (unsigned char *input, unsigned char *output);
+DBX_EXTFUN(int)         dbx_nextnode_x                (DBXMETH *pmeth);
+DBX_EXTFUN(int)         dbx_nextnode_data             (unsigned char *input, unsigned char *output);
+DBX_EXTFUN(int)         dbx_nextnode_data_x           (DBXMETH *pmeth);
+DBX_EXTFUN(int)         dbx_previousnode              (unsigned char *input, unsigned char *output);
+DBX_EXTFUN(int)         dbx_previousnode_x            (DBXMETH *pmeth);
+DBX_EXTFUN(int)         dbx_previousnode_data         (unsigned char *input, unsigned char *output);
+DBX_EXTFUN(int)         dbx_previousnode_data_x       (DBXMETH *pmeth);
+DBX_EXTFUN(int)         dbx_query_x                   (DBXMETH *pmeth);
+DBX_EXTFUN(int)         dbx_query_ex                  (DBXMETH *pmeth);
 DBX_EXTFUN(int)         dbx_delete                    (unsigned char *input, unsigned char *output);
 DBX_EXTFUN(int)         dbx_delete_x                  (DBXMETH *pmeth);
 DBX_EXTFUN(int)         dbx_delete_ex                 (DBXMETH *pmeth);
@@ -1222,6 +1623,13 @@ DBX_EXTFUN(int)         dbx_lock_ex                   (DBXMETH *pmeth);
 DBX_EXTFUN(int)         dbx_unlock                    (unsigned char *input, unsigned char *output);
 DBX_EXTFUN(int)         dbx_unlock_x                  (DBXMETH *pmeth);
 DBX_EXTFUN(int)         dbx_unlock_ex                 (DBXMETH *pmeth);
+DBX_EXTFUN(int)         dbx_lock_many                 (unsigned char *input, unsigned char *output);
+DBX_EXTFUN(int)         dbx_lock_many_x               (DBXMETH *pmeth);
+DBX_EXTFUN(int)         dbx_lock_many_ex              (DBXMETH *pmeth);
+DBX_EXTFUN(int)         dbx_unlock_many               (unsigned char *input, unsigned char *output);
+DBX_EXTFUN(int)         dbx_unlock_many_x             (DBXMETH *pmeth);
+DBX_EXTFUN(int)         dbx_unlock_many_ex            (DBXMETH *pmeth);
+DBX_EXTFUN(int)         dbx_lock_stats                (unsigned char *input, unsigned char *output);
 DBX_EXTFUN(int)         dbx_tstart                    (unsigned char *input, unsigned char *output);
 DBX_EXTFUN(int)         dbx_tstart_ex                 (DBXMETH *pmeth);
 DBX_EXTFUN(int)         dbx_tlevel                    (unsigned char *input, unsigned char *output);
@@ -1240,18 +1648,44 @@ DBX_EXTFUN(int)         dbx_method_x                  (DBXMETH *pmeth);
 DBX_EXTFUN(int)         dbx_getproperty               (unsigned char *input, unsigned char *output);
 DBX_EXTFUN(int)         dbx_getproperty_x             (DBXMETH *pmeth);
 DBX_EXTFUN(int)         dbx_setproperty               (unsigned char *input, unsigned char *output);
+DBX_EXTFUN(int)         dbx_getproperties             (unsigned char *input, unsigned char *output);
+DBX_EXTFUN(int)         dbx_getproperties_x           (DBXMETH *pmeth);
+DBX_EXTFUN(int)         dbx_setproperties             (unsigned char *input, unsigned char *output);
+DBX_EXTFUN(int)         dbx_setproperties_x           (DBXMETH *pmeth);
 DBX_EXTFUN(int)         dbx_closeinstance             (unsigned char *input, unsigned char *output);
+DBX_EXTFUN(int)         dbx_closeinstances            (unsigned char *input, unsigned char *output);
+DBX_EXTFUN(int)         dbx_closeinstances_x          (DBXMETH *pmeth);
 DBX_EXTFUN(int)         dbx_getnamespace              (unsigned char *input, unsigned char *output);
 DBX_EXTFUN(int)         dbx_setnamespace              (unsigned char *input, unsigned char *output);
 DBX_EXTFUN(int)         dbx_sleep                     (int period_ms);
+DBX_EXTFUN(int)         dbx_deadline                  (int index, int period_ms);
 DBX_EXTFUN(int)         dbx_benchmark                 (unsigned char *inputstr, unsigned char *outputstr);
+DBX_EXTFUN(int)         dbx_cache_global              (char *global, int ttl);
+DBX_EXTFUN(int)         dbx_cache_limits              (int max_entries, int max_size);
+DBX_EXTFUN(int)         dbx_cache_clear               (void);
+DBX_EXTFUN(int)         dbx_buffer                    (unsigned char *input, unsigned char *output);
+DBX_EXTFUN(int)         dbx_flush                     (unsigned char *input, unsigned char *output);
+DBX_EXTFUN(int)         dbx_standby                   (unsigned char *input, unsigned char *output);
 
 int                     isc_load_library              (DBXCON *pcon);
 int                     isc_authenticate              (DBXCON *pcon);
+int                     isc_session_start             (DBXCON *pcon);
+#if defined(_WIN32)
+DWORD WINAPI            isc_session_thread            (LPVOID pargs);
+#else
+void *                  isc_session_thread            (void *pargs);
+#endif
+DBXSESS *               isc_session                   (unsigned char *input);
+int                     isc_session_call              (int (* p_fun) (unsigned char *input, unsigned char *output), unsigned char *input, unsigned char *output);
 int                     isc_open                      (DBXMETH *pmeth);
 int                     isc_parse_zv                  (char *zv, DBXZV * p_isc_sv);
 int                     isc_change_namespace          (DBXCON *pcon, char *nspace);
+int                     isc_lock_command              (DBXMETH *pmeth, int *nodes, int *nsubs, int nnodes, int timeout, CACHE_ASTR *cmd);
 int                     isc_pop_value                 (DBXCON *pcon, DBXVAL *value, int required_type);
+int                     isc_push_value                (DBXCON *pcon, DBXVAL *value);
+int                     isc_push_node                 (DBXCON *pcon, DBXSTR *global, char *buffer, int nkeys, int *kpos, int *klen);
+int                     isc_list_item                 (unsigned char *list, int list_len, int *offset, char *buffer, int buffer_size);
+int                     isc_list_number               (char *buffer, long long mant, int exp);
 int                     isc_error_message             (DBXMETH *pmeth, int error_code);
 
 int                     ydb_load_library              (DBXCON *pcon);
@@ -1261,7 +1695,26 @@ int                     ydb_get_intsvar               (DBXCON *pcon, char *svarn
 int                     ydb_error_message             (DBXMETH *pmeth, int error_code);
 int                     ydb_function                  (DBXMETH *pmeth, DBXFUN *pfun);
 int                     ydb_function_ex               (DBXMETH *pmeth, DBXFUN *pfun);
+ci_name_descriptor *    ydb_ci_descriptor             (DBXCON *pcon, char *name, int name_len);
+int                     ydb_ci_call                   (DBXCON *pcon, char *name, int name_len, int argc, void **argv);
+int                     ydb_ci_free                   (DBXCON *pcon);
+int                     ydb_load_library_st           (DBXCON *pcon);
+ydb_buffer_t *          ydb_thread_errstr             (ydb_buffer_t *errstr);
+int                     ydb_thread_status             (ydb_buffer_t *errstr, int rc);
+int                     ydb_thread_data               (ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray, unsigned int *ret_value);
+int                     ydb_thread_delete             (ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray, int deltype);
+int                     ydb_thread_set                (ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray, ydb_buffer_t *value);
+int                     ydb_thread_get                (ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray, ydb_buffer_t *ret_value);
+int                     ydb_thread_subscript_next     (ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray, ydb_buffer_t *ret_value);
+int                     ydb_thread_subscript_previous (ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray, ydb_buffer_t *ret_value);
+int                     ydb_thread_node_next          (ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray, int *ret_subs_used, ydb_buffer_t *ret_subsarray);
+int                     ydb_thread_node_previous      (ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray, int *ret_subs_used, ydb_buffer_t *ret_subsarray);
+int                     ydb_thread_incr               (ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray, ydb_buffer_t *increment, ydb_buffer_t *ret_value);
+int                     ydb_thread_lock_incr          (unsigned long long timeout_nsec, ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray);
+int                     ydb_thread_lock_decr          (ydb_buffer_t *varname, int subs_used, ydb_buffer_t *subsarray);
+int                     ydb_transaction_exec          (DBXMETH *pmeth, int context);
 int                     ydb_transaction_cb            (void *pargs);
+int                     ydb_transaction_cb_st         (unsigned long long tptoken, ydb_buffer_t *errstr, void *pargs);
 #if defined(_WIN32)
 LPTHREAD_START_ROUTINE  ydb_transaction_thread        (LPVOID pargs);
 #else
@@ -1279,6 +1732,11 @@ DBXMETH *               mg_unpack_header              (unsigned char *input, uns
 int                     mg_unpack_arguments           (DBXMETH *pmeth);
 int                     mg_global_reference           (DBXMETH *pmeth);
 int                     mg_function_reference         (DBXMETH *pmeth, DBXFUN *pfun);
+DBXFREF *               mg_function_cache             (DBXCON *pcon, char *ref, int ref_len);
+int                     mg_function_cache_clear       (DBXCON *pcon, int context);
+int                     mg_oref_add                   (DBXCON *pcon, int oref);
+int                     mg_oref_release               (DBXCON *pcon, int oref);
+int                     mg_oref_free                  (DBXCON *pcon);
 int                     mg_class_reference            (DBXMETH *pmeth, short context);
 
 int                     mg_add_block_head             (DBXSTR *block, unsigned long buffer_size, unsigned long index);
@@ -1298,6 +1756,9 @@ int                     mg_buf_cat                    (MGBUF *p_buf, char * buff
 void *                  mg_realloc                    (void *p, int curr_size, int new_size, short id);
 void *                  mg_malloc                     (int size, short id);
 int                     mg_free                       (void *p, short id);
+void *                  mg_arena_alloc                (DBXCON *pcon, unsigned long size);
+int                     mg_arena_reset                (DBXCON *pcon);
+int                     mg_arena_free                 (DBXCON *pcon);
 
 int                     mg_ucase                      (char *string);
 int                     mg_lcase                      (char *string);
@@ -1309,6 +1770,9 @@ int                     mg_pause                      (int msecs);
 DBXPLIB                 mg_dso_load                   (char *library);
 DBXPROC                 mg_dso_sym                    (DBXPLIB p_library, char *symbol);
 int                     mg_dso_unload                 (DBXPLIB p_library);
+void *                  mg_library_get                (DBXCON *pcon);
+int                     mg_library_add                (DBXCON *pcon, void *p_so);
+int                     mg_library_release            (DBXCON *pcon);
 DBXTHID                 mg_current_thread_id          (void);
 unsigned long           mg_current_process_id         (void);
 int                     mg_error_message              (DBXMETH *pmeth, int error_code);
@@ -1316,8 +1780,31 @@ int                     mg_set_error_message          (DBXMETH *pmeth);
 int                     mg_set_error_message_ex       (unsigned char *output, char *error_message);
 int                     mg_cleanup                    (DBXMETH *pmeth);
 
+int                     mg_cache_server               (DBXCON *pcon, unsigned char *key, int key_size);
+int                     mg_namespace_set              (DBXCON *pcon, char *nspace);
+int                     mg_cache_key                  (DBXMETH *pmeth, unsigned char *key, int key_size, int exclude, int *ttl);
+int                     mg_cache_get                  (DBXMETH *pmeth, unsigned char *key, int key_len, unsigned long long *generation);
+int                     mg_cache_put                  (unsigned char *key, int key_len, int ttl, unsigned char *data, int data_len, unsigned long long generation);
+int                     mg_cache_invalidate           (unsigned char *key, int key_len, int context);
+int                     mg_cache_remove               (DBXCENT *pent);
+unsigned long           mg_cache_hash                 (unsigned char *key, int key_len);
+unsigned long long      mg_time_ms                    (void);
+int                     mg_lock_list                  (DBXMETH *pmeth, int *nodes, int *nsubs, int max);
+int                     mg_lock_node                  (DBXMETH *pmeth, int node, int nsubs, int lock, int timeout, int *retval);
+int                     mg_lock_stat                  (DBXCON *pcon, int nlocks, unsigned long long wait_start, int timed_out);
+unsigned long           mg_lock_hash                  (DBXMETH *pmeth, int node, int nsubs);
+int                     mg_lock_held                  (DBXCON *pcon, unsigned long hash, int lock);
+int                     mg_lock_free                  (DBXCON *pcon);
+int                     mg_lock_timeout               (DBXCON *pcon, int timeout, unsigned long long *timeout_ms);
+int                     mg_deadline_ms                (DBXCON *pcon);
+int                     mg_wbuf_add                   (DBXMETH *pmeth);
+int                     mg_wbuf_flush                 (DBXCON *pcon);
+int                     mg_wbuf_error                 (DBXMETH *pmeth);
+int                     mg_wbuf_clear                 (DBXWBUF *pwbuf);
+
 int                     mg_mutex_create               (DBXMUTEX *p_mutex);
 int                     mg_mutex_lock                 (DBXMUTEX *p_mutex, int timeout);
+int                     mg_mutex_lock_deadline        (DBXMUTEX *p_mutex, DBXCON *pcon);
 int                     mg_mutex_unlock               (DBXMUTEX *p_mutex);
 int                     mg_mutex_destroy              (DBXMUTEX *p_mutex);
 int                     mg_init_critical_section      (void *p_crit);
@@ -1332,9 +1819,25 @@ int                     netx_tcp_connect              (DBXCON *pcon, int context
 int                     netx_tcp_handshake            (DBXCON *pcon, int context);
 int                     netx_tcp_command              (DBXMETH *pmeth, int context);
 int                     netx_tcp_connect_ex           (DBXCON *pcon, xLPSOCKADDR p_srv_addr, socklen_netx srv_addr_len, int timeout);
+int                     netx_unix_connect             (DBXCON *pcon, int context);
+int                     netx_stby_open                (DBXSTBY *pstby, SOCKET *psocket, char *error);
+int                     netx_stby_close               (SOCKET sock);
+int                     netx_stby_start               (void);
+#if defined(_WIN32)
+DWORD WINAPI            netx_stby_thread              (LPVOID arg);
+#else
+void *                  netx_stby_thread              (void *arg);
+#endif
+int                     netx_tcp_command_stby         (DBXMETH *pmeth, int context);
+int                     netx_tcp_idempotent           (int cmnd);
+int                     netx_tcp_failover             (DBXCON *pcon);
+int                     netx_stby_namespace           (DBXCON *pcon);
 int                     netx_tcp_disconnect           (DBXCON *pcon, int context);
 int                     netx_tcp_write                (DBXCON *pcon, unsigned char *data, int size);
+int                     netx_tcp_writev               (DBXCON *pcon, NETXIOV *iov, int iovcnt);
+int                     netx_tcp_wait_write           (DBXCON *pcon, int timeout);
 int                     netx_tcp_read                 (DBXCON *pcon, unsigned char *data, int size, int timeout, int context);
+int                     netx_tcp_step                 (DBXCON *pcon, int timeout, unsigned long long start, struct timeval *tval);
 int                     netx_get_last_error           (int context);
 int                     netx_get_error_message        (int error_code, char *message, int size, int context);
 int                     netx_get_std_error_message    (int error_code, char *message, int size, int context);
@@ -1344,7 +1847,11 @@ int                     mg_db_command                 (DBXMETH *pmeth, int conte
 int                     mg_db_connect                 (MGSRV *p_srv, int *chndle, short context);
 int                     mg_db_disconnect              (MGSRV *p_srv, int chndle, short context);
 int                     mg_db_send                    (MGSRV *p_srv, int chndle, MGBUF *p_buf, int mode);
+int                     mg_db_sendv                   (MGSRV *p_srv, int chndle, NETXIOV *iov, int iovcnt, int mode);
 int                     mg_db_receive                 (MGSRV *p_srv, int chndle, MGBUF *p_buf, int size, int mode);
+int                     mg_db_receive_output          (MGSRV *p_srv, int chndle, DBXMETH *pmeth);
+MGBUFS *                mg_db_buffers                 (DBXCON *pcon);
+int                     mg_db_free_buffers            (DBXCON *pcon);
 int                     mg_db_connect_init            (MGSRV *p_srv, int chndle);
 int                     mg_db_ayt                     (MGSRV *p_srv, int chndle);
 int                     mg_db_get_last_error          (int context);
@@ -1358,6 +1865,7 @@ int                     mg_encode_size                (unsigned char *esize, int
 int                     mg_decode_size                (unsigned char *esize, int len, short base);
 int                     mg_encode_item_header         (unsigned char * head, int size, short byref, short type);
 int                     mg_decode_item_header         (unsigned char * head, int * size, short * byref, short * type);
+int                     mg_benchmark_codec            (unsigned char *inputstr);
 int                     mg_get_error                  (MGSRV *p_srv, char *buffer);
 
 int                     mg_extract_substrings         (MGSTR * records, char* buffer, int tsize, char delim, int offset, int no_tail, short type);
@@ -0,0 +1,46 @@
+/*
+   ----------------------------------------------------------------------------
+   | mg_dba_train                                                             |
+   | Description: Training run for a profile guided build of the mg_dba       |
+   |              static library (make train PGO=generate)                    |
+   | Author:      Chris Munt cmunt@mgateway.com                               |
+   |                         chris.e.munt@gmail.com                           |
+   | Copyright (c) 2019-2023 MGateway Ltd                                     |
+   | Surrey UK.                                                               |
+   | All rights reserved.                                                     |
+   |                                                                          |
+   | http://www.mgateway.com                                                  |
+   |                                                                          |
+   | Licensed under the Apache License, Version 2.0 (the "License"); you may  |
+   | not use this file except in compliance with the License.                 |
+   | You may obtain a copy of the License at                                  |
+   |                                                                          |
+   | http://www.apache.org/licenses/LICENSE-2.0                               |
+   |                                                                          |
+   | Unless required by applicable law or agreed to in writing, software      |
+   | distributed under the License is distributed on an "AS IS" BASIS,        |
+   | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+   | See the License for the specific language governing permissions and      |
+   | limitations under the License.                                           |
+   |                                                                          |
+   ----------------------------------------------------------------------------
+*/
+
+/*
+   v1.3.22: run the built-in benchmark ('codec <n>') against the instrumented object so that
+   the network protocol's size codecs are profiled without a database.  The profile data is
+   written when the program exits.
+*/
+
+#include "mg_dba.h"
+
+int main(int argc, char *argv[])
+{
+   unsigned char buffer[256];
+
+   sprintf((char *) buffer, "codec %.32s", (argc > 1) ? argv[1] : "1000000");
+   dbx_benchmark(buffer, NULL);
+   printf("%s\n", (char *) buffer);
+
+   return 0;
+}